@@ -2,49 +2,92 @@
 #define CHANNEL_HPP
 
 #include <iostream>
-#include <set>
+#include <vector>
+#include <ctime>
+#include "NamesList.hpp"
+
+class Client;
 
 #define TOPICSET     0b000001 // if set topic is settable by channel operator only
 #define INVITEONLY      0b000010 // if set clients can join only if invited
 #define KEYSET            0b000100 // if set clients can join only with password
 #define LIMITSET        0b001000 // if set no more clients than limit value can join
 
+enum MemberFlag {
+    MEMBER_JOINED = 0b0001, // on the channel, invites alone keep an entry too
+    MEMBER_OPERATOR = 0b0010,
+    MEMBER_VOICE = 0b0100,
+    MEMBER_INVITED = 0b1000,
+    MEMBER_INVISIBLE = 0b10000 // joined with user mode +i, left out of the visible names
+};
+
+struct Member {
+    int fd;
+    unsigned char flags;
+    size_t namesChunk; // chunks holding the entry while joined
+    size_t visibleChunk;
+    std::string nickname;
+};
+
+static const size_t MEMBER_INDEX_THRESHOLD = 64; // entries scanned before a channel keeps an fd index
+
 class Channel {
     private:
         std::string _name;
         std::string _topic;
         unsigned int _mode;
         std::string _password;
-        std::set<int> _memberFds;
-        std::set<int> _operatorFds;
-        std::set<int> _invitedFds;
+        std::vector<Member> _members; // walked linearly for broadcasts
+        std::vector<int> _positions; // fd -> index in _members, built for large channels only
+        size_t _memberCount; // entries with MEMBER_JOINED
         int _limitMembers;
+        time_t _created;
+        time_t _topicTime; // when the current topic was set
+        NamesList _names; // "@nick" or "nick" per joined member
+        NamesList _visibleNames; // the same without invisible members
+
+        int position(int clientFd) const;
+        bool hasFlag(int clientFd, unsigned char flag) const;
+        bool setFlag(int clientFd, unsigned char flag);
+        bool clearFlag(int clientFd, unsigned char flag);
+        void eraseEntry(int index);
+        static std::string nameEntry(const Member &member);
+        void listName(Member &member);
+        void unlistName(const Member &member);
+        void compactNames();
 
     public:
-        Channel(const std::string &name, std::string &password);
+        Channel(const std::string &name, const std::string &password, size_t namesLimit);
         ~Channel();
         const std::string &getName() const;
         const std::string &getTopic() const;
         std::string getModeString() const;
         std::string getModeStringWithParameters() const;
-        const std::set<int> &getMemberFds() const;
+        const std::vector<Member> &getMembers() const;
+        size_t getMemberCount() const;
         int getLimitMembers() const;
+        time_t getCreationTime() const;
+        time_t getTopicTime() const;
+        const NamesList &getNames() const;
+        const NamesList &getVisibleNames() const;
         void setTopic(const std::string &topic);
         void setPassword(const std::string &password);
         void setLimitMembers(int limitMembers);
         bool setMode(unsigned int mode);
         bool unsetMode(unsigned int mode);
         bool isModeSet(unsigned int mode) const;
-        void addMember(int clientFd);
+        void addMember(const Client *client);
         void removeMember(int clientFd);
-        bool hasMember(int clientFd);
+        bool hasMember(int clientFd) const;
+        void renameMember(int clientFd, const std::string &nickname);
+        void setMemberInvisible(int clientFd, bool invisible);
         bool addOperator(int clientFd);
         bool removeOperator(int clientFd);
         bool hasOperator(int clientFd) const;
         void addInvited(int clientFd);
         void removeInvited(int clientFd);
-        bool hasInvited(int clientFd);
-        bool authMember(int clientFd, std::string &password);
+        bool hasInvited(int clientFd) const;
+        bool authMember(const Client *client, const std::string &password);
 };
 
 
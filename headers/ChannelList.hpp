@@ -0,0 +1,54 @@
+#ifndef CHANNELLIST_HPP
+#define CHANNELLIST_HPP
+
+#include <string>
+#include <vector>
+#include <set>
+#include <ctime>
+#include "Channel.hpp"
+#include "ClientTable.hpp"
+#include "Mask.hpp"
+
+static const size_t LIST_PAGE_SIZE = 64; // RPL_LIST lines queued each time the client's output drains
+static const size_t LIST_SCAN_LIMIT = 1024; // channels a page looks at before yielding to the loop
+
+typedef std::pair<size_t, std::string> DirectoryKey; // member count, folded name
+
+// largest channels first, ties by name
+struct DirectoryOrder {
+	bool operator()(const DirectoryKey &a, const DirectoryKey &b) const;
+};
+
+typedef std::set<DirectoryKey, DirectoryOrder> ChannelDirectory;
+
+// ELIST conditions of a LIST request, every condition set has to hold:
+//   >n <n        more or fewer than n members
+//   C>n C<n      created more or less than n minutes ago
+//   T>n T<n      topic set more or less than n minutes ago
+//   mask !mask   channel name matching or not matching a glob
+//   T:mask       topic matching a glob
+struct ListFilter {
+	size_t moreThan;
+	size_t lessThan; // 0 when unset
+	long createdBefore; // seconds of age, -1 when unset
+	long createdAfter;
+	long topicBefore;
+	long topicAfter;
+	std::vector<Mask> masks;
+	std::vector<Mask> excludedMasks;
+	std::vector<Mask> topicMasks;
+
+	ListFilter();
+	bool add(const std::string &condition); // false when it names a channel instead
+	bool matches(const Channel &channel, time_t now) const;
+};
+
+// A LIST walking the directory, resumed page by page from the last key sent
+struct ListPager {
+	ClientHandle client;
+	ListFilter filter;
+	DirectoryKey cursor;
+	bool started;
+};
+
+#endif
@@ -9,30 +9,75 @@
 #include <unistd.h>
 #include <set>
 #include <queue>
+#include <vector>
+#include <climits>
+#include <sys/uio.h>
+#include "TimerWheel.hpp"
+#include "Payload.hpp"
 
 
+#ifdef IOV_MAX
+static const int SEND_IOV_MAX = IOV_MAX; // messages gathered by a single writev
+#else
+static const int SEND_IOV_MAX = 1024;
+#endif
+
+class Channel;
+
+static const size_t RECV_CHUNK = 4096; // free space guaranteed to each recv call
+static const size_t RECV_LINE_MAX = 16384; // buffered bytes without a line feed before they are discarded
+
 enum Mode {
     AWAY = 0b000001, // a: user is flagged as away
     INVISIBLE = 0b001000, // i: marks a users as invisible
     UNKNOWN
 };
 
+enum ClientState {
+    CLIENT_LOGGED = 0b00001,
+    CLIENT_REGISTERED = 0b00010,
+    CLIENT_QUIT = 0b00100,
+    CLIENT_PENDING_WRITE = 0b01000, // listed in the server's writers since its last flush
+    CLIENT_RECV_DISCARDING = 0b10000 // skipping the rest of an oversized line
+};
+
+static const size_t SEND_QUEUE_KEEP = 64; // queue slots kept by a drained client, larger arrays are freed
+
+// Rarely read data, allocated the first time one of its fields is set
+struct ClientProfile {
+    std::string realName;
+    std::string awayMessage;
+    std::vector<Channel *> invites; // channels holding a pending invite for this client
+};
+
 class Client {
     private:
+        // read by the event loop and channel fan-out
         int         _socketFd;
-        bool        _logged;
-        bool        _registered;
-        unsigned int _modes;
+        unsigned char _state; // ClientState bits
+        unsigned char _modes;
+        std::vector<PayloadRef> _sendQueue; // pending messages start at _sendHead
+        size_t      _sendHead;
+        size_t      _sendOffset; // bytes of the head message already written
+        std::vector<char> _recvBuffer; // received bytes live in [_recvStart, _recvEnd), freed once drained
+        size_t      _recvStart;
+        size_t      _recvEnd;
+        std::string _prefix; // "nick!~user@host", rebuilt when the nickname or username changes
         std::string _nickname;
+        std::vector<Channel *> _channels; // joined, each one lists this client back
+        unsigned int _mark; // epoch of the last neighbour walk that reached this client
+        Timer       _timer;
+        unsigned long _lastActivity; // ms timestamp of the last data received
+        unsigned long _pingSent; // ms timestamp of the last keepalive PING
+        // cold
         std::string _username;
-		std::string _realName;
-        std::string _password;
-		std::string _hostname;
-		std::string	_recvBuffer;
-		std::queue<std::string> _sendQueue;
-		std::string _awayMessage;
-		std::vector<std::string> _channels;
-		bool 		_quit;
+        std::string _hostname;
+        ClientProfile *_profile;
+
+        Client(const Client &other);
+        Client &operator=(const Client &other);
+        ClientProfile &profile();
+        void setState(unsigned char flag, bool set);
 
     public:
         Client(int socket, std::string hostname);
@@ -40,18 +85,18 @@ class Client {
 
         const std::string &getNickname() const;
         const std::string &getUsername() const;
-        const std::string &getPassword() const;
 		const std::string &getHostname() const;
+		const std::string &getPrefix() const;
         int getSocket() const;
 		const std::string &getAwayMessage() const;
-		const std::vector<std::string> &getChannels() const;
+		const std::vector<Channel *> &getChannels() const;
+		const std::vector<Channel *> &getInvites() const;
 		bool isQuit() const;
 		void setQuit(bool quit);
 	    bool isRegistered() const;
         bool isLogged() const;
         void setNickname(const std::string &nickname);
         void setUsername(const std::string &username);
-        void setPassword(const std::string &password);
         void setRegistration();
 		void setRealName(const std::string &real_name);
 		void setLog();
@@ -61,16 +106,30 @@ class Client {
         bool activeMode(Mode mode) const;
         Mode getMode(const std::string &mode);
         std::string returnModes();
-		std::string getRecvBuffer();
-		void appendRecvBuffer(std::string recv);
-		void resetRecvBuffer();
-		bool isRecvBufferEmpty();
+		void updatePrefix();
+		char *recvSpace(size_t &available);
+		void recvCommit(size_t bytes);
+		void appendRecvBuffer(const char *data, size_t length);
+		bool nextLine(const char *&line, size_t &length);
 		std::string getRealName() const;
-		void pushSendQueue(std::string send);
-		std::string popSendQueue();
+		void pushSendQueue(const PayloadRef &send);
+		int fillSendVector(iovec *iov, int maxCount, size_t &bytes) const;
+		void consumeSendQueue(size_t bytes);
 		bool sendQueueEmpty();
-		void addChannel(const std::string &channel);
-		void removeChannel(const std::string &channel);
+		void releaseRecvBuffer();
+		bool isPendingWrite() const;
+		void setPendingWrite(bool pending);
+		void addChannel(Channel *channel);
+		void removeChannel(Channel *channel);
+		void addInvite(Channel *channel);
+		void removeInvite(Channel *channel);
+		Timer &getTimer();
+		unsigned long getLastActivity() const;
+		void setLastActivity(unsigned long now);
+		unsigned long getPingSent() const;
+		void setPingSent(unsigned long now);
+		unsigned int getMark() const;
+		void setMark(unsigned int epoch);
 };
 
 #endif
@@ -0,0 +1,52 @@
+#ifndef CLIENTTABLE_HPP
+#define CLIENTTABLE_HPP
+
+#include <string>
+#include <vector>
+#include "Client.hpp"
+
+// Names one connection: the generation tells a reused descriptor apart
+struct ClientHandle {
+	int fd;
+	unsigned int generation;
+
+	ClientHandle();
+	ClientHandle(int fd, unsigned int generation);
+};
+
+// Clients indexed by descriptor, constructed in place in a slab allocated
+// once at startup. Lookups never allocate nor throw, misses return NULL.
+class ClientTable {
+	private:
+		struct Slot {
+			unsigned int generation; // 0 while the slot is free
+			int fd;
+			size_t position; // index in _fds
+		};
+
+		Client *_slab;
+		std::vector<Slot> _slots;
+		std::vector<int> _free; // unused slots
+		std::vector<int> _fdSlots; // descriptor -> slot, -1 when unused
+		std::vector<int> _fds; // live descriptors, in no particular order
+		unsigned int _nextGeneration;
+
+		ClientTable(const ClientTable &other);
+		ClientTable &operator=(const ClientTable &other);
+
+	public:
+		explicit ClientTable(size_t capacity = 0);
+		~ClientTable();
+
+		// NULL when the table is full
+		Client *create(int fd, const std::string &hostname);
+		void destroy(int fd);
+		Client *operator[](int fd) const;
+		Client *find(const ClientHandle &handle) const;
+		ClientHandle handle(int fd) const;
+		const std::vector<int> &fds() const;
+		size_t size() const;
+		size_t capacity() const;
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef CONFIG_HPP
+#define CONFIG_HPP
+
+#include <string>
+#include "EventLoop.hpp"
+
+// Runtime tunables, set from the optional --key=value arguments after <port> <password>
+struct Config {
+	EventLoop::Backend backend;
+	unsigned long registrationTimeout; // seconds allowed to complete PASS/NICK/USER
+	unsigned long pingInterval; // seconds of silence before the server sends a PING
+	unsigned long pingTimeout; // seconds allowed to answer a PING
+	unsigned long acceptBatch; // connections accepted per listener wakeup
+	unsigned long maxClients; // client slots allocated at startup
+	int cpu; // CPU the event loop thread is pinned to, -1 to let the scheduler decide
+
+	Config();
+	void parseOption(const std::string &option);
+	void applyCpuAffinity() const;
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef EPOLLLOOP_HPP
+#define EPOLLLOOP_HPP
+
+#ifdef __linux__
+
+#include <sys/epoll.h>
+#include "EventLoop.hpp"
+
+class EpollLoop : public EventLoop {
+	private:
+		int _epollFd;
+		bool _edgeTriggered;
+		std::vector<unsigned int> _interest; // registered events indexed by fd, avoids redundant epoll_ctl
+		epoll_event _events[MAX_READY_EVENTS];
+
+		void control(int op, int fd, unsigned int events);
+
+	public:
+		explicit EpollLoop(bool edgeTriggered);
+		~EpollLoop();
+
+		const char *name() const;
+		bool edgeTriggered() const;
+		void add(int fd, unsigned int events);
+		void modify(int fd, unsigned int events);
+		void remove(int fd);
+		void wait(std::vector<IoReady> &ready, int timeoutMs);
+};
+
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef EVENTLOOP_HPP
+#define EVENTLOOP_HPP
+
+#include <string>
+#include <vector>
+
+enum IoEvent {
+	EV_READ = 0b001, // data (or a pending connection) can be read
+	EV_WRITE = 0b010, // socket has room in its send buffer
+	EV_CLOSE = 0b100, // hang-up or error reported on the descriptor
+	EV_ACCEPT = 0b1000 // listening socket (add) or newly accepted socket (completion backends)
+};
+
+static const int MAX_READY_EVENTS = 1024; // events fetched by a single epoll_wait
+
+struct IoReady {
+	int fd;
+	unsigned int events;
+	const char *data; // bytes already received, completion backends only
+	size_t length;
+};
+
+// Readiness notification backend used by Server::run. Only descriptors with
+// pending events are reported, so the loop cost follows active sockets.
+class EventLoop {
+	public:
+		enum Backend {
+			POLL,
+			EPOLL,
+			EPOLL_ET,
+			IO_URING
+		};
+
+		virtual ~EventLoop() {}
+		static EventLoop *create(Backend backend);
+		static bool parseBackend(const std::string &name, Backend &backend);
+		static Backend defaultBackend();
+
+		virtual const char *name() const = 0;
+		// readiness is only reported on transitions: sockets must be drained until EAGAIN
+		virtual bool edgeTriggered() const = 0;
+		// the backend performs the I/O itself: received bytes come with the events
+		// and outgoing bytes are handed over with send()
+		virtual bool completionBased() const;
+		virtual void add(int fd, unsigned int events) = 0;
+		virtual void modify(int fd, unsigned int events) = 0;
+		virtual void remove(int fd) = 0;
+		virtual void closeDescriptor(int fd);
+		virtual void send(int fd, const char *data, size_t length);
+		// bytes handed over with send() that the backend has not written yet
+		virtual size_t pendingOutput(int fd) const;
+		// blocks up to timeoutMs (-1 for no limit) and fills ready with the active descriptors
+		virtual void wait(std::vector<IoReady> &ready, int timeoutMs) = 0;
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef MASK_HPP
+#define MASK_HPP
+
+#include <string>
+
+// Case-insensitive glob match: '*' matches any run of characters, '?' any one
+bool matchMask(const std::string &mask, const std::string &text);
+
+// A glob folded and inspected once, then matched against many names. The
+// literal text before the first wildcard lets sorted indexes narrow the
+// candidates, "*" and masks without wildcards skip the glob scan.
+class Mask {
+	private:
+		std::string _pattern; // folded
+		std::string _prefix; // literal text before the first wildcard
+		bool _wildcards;
+		bool _all; // only stars
+
+	public:
+		Mask();
+		explicit Mask(const std::string &pattern);
+		bool match(const std::string &text) const;
+		bool matchesAll() const;
+		bool exact() const;
+		const std::string &prefix() const;
+};
+
+#endif
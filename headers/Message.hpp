@@ -0,0 +1,39 @@
+#ifndef MESSAGE_HPP
+#define MESSAGE_HPP
+
+#include <string>
+#include <cstddef>
+
+static const size_t MESSAGE_MAX_PARAMS = 15; // RFC 2812, the last one swallows the rest of the line
+static const size_t MESSAGE_LINE_MAX = 512; // RFC 2812, CR-LF included
+
+// Bytes borrowed from the receive buffer, valid while the line is processed
+struct Slice {
+	const char *data;
+	size_t length;
+
+	Slice();
+	Slice(const char *data, size_t length);
+	bool empty() const;
+	char first() const; // '\0' when empty
+	std::string str() const;
+	bool operator==(const char *other) const;
+	bool operator!=(const char *other) const;
+};
+
+// One parsed line: [@tags] [:prefix] command [params] [:trailing]
+// Parsing only records slices of the line, it never allocates.
+struct Message {
+	Slice tags; // without the leading '@'
+	Slice prefix; // without the leading ':'
+	Slice command;
+	Slice params[MESSAGE_MAX_PARAMS];
+	size_t paramCount;
+	bool trailing; // the last parameter was given after ':' and kept verbatim
+
+	Message();
+	// false when the line holds no command
+	bool parse(const char *line, size_t length);
+};
+
+#endif
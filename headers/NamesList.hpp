@@ -0,0 +1,26 @@
+#ifndef NAMESLIST_HPP
+#define NAMESLIST_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// A names list rendered as space separated chunks, each one fits the text of
+// a single RPL_NAMREPLY line. Entries are added to the last chunk and erased
+// in place, so an update only touches one chunk.
+class NamesList {
+	private:
+		std::vector<std::string> _chunks;
+		size_t _limit; // bytes of entries per chunk
+		size_t _bytes; // entry bytes over all chunks, separators included
+
+	public:
+		NamesList(size_t limit);
+		size_t insert(const std::string &entry); // returns the chunk holding the entry
+		void erase(size_t chunk, const std::string &entry);
+		void clear();
+		bool fragmented() const;
+		const std::vector<std::string> &chunks() const;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef PAYLOAD_HPP
+#define PAYLOAD_HPP
+
+#include <string>
+#include <cstddef>
+
+// Immutable, reference counted message bytes. A broadcast is formatted once
+// and every recipient's send queue holds a reference to the same payload.
+class Payload {
+	private:
+		size_t _refs;
+		size_t _length;
+
+		explicit Payload(size_t length);
+		~Payload();
+		Payload(const Payload &other);
+		Payload &operator=(const Payload &other);
+
+	public:
+		// header and bytes come from a single allocation
+		static Payload *create(size_t length);
+		static Payload *create(const std::string &message);
+		void retain();
+		void release();
+		char *data();
+		const char *data() const;
+		size_t length() const;
+};
+
+// Owning handle on a Payload, copying it shares the bytes
+class PayloadRef {
+	private:
+		Payload *_payload;
+
+	public:
+		PayloadRef();
+		explicit PayloadRef(Payload *payload);
+		explicit PayloadRef(const std::string &message);
+		PayloadRef(const PayloadRef &other);
+		PayloadRef &operator=(const PayloadRef &other);
+		~PayloadRef();
+
+		const char *data() const;
+		size_t length() const;
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef POLLLOOP_HPP
+#define POLLLOOP_HPP
+
+#include <poll.h>
+#include "EventLoop.hpp"
+
+class PollLoop : public EventLoop {
+	private:
+		std::vector<pollfd> _pollFds;
+		std::vector<int> _slots; // position in _pollFds indexed by fd, -1 when not registered
+
+		pollfd *find(int fd);
+
+	public:
+		PollLoop();
+		~PollLoop();
+
+		const char *name() const;
+		bool edgeTriggered() const;
+		void add(int fd, unsigned int events);
+		void modify(int fd, unsigned int events);
+		void remove(int fd);
+		void wait(std::vector<IoReady> &ready, int timeoutMs);
+};
+
+#endif
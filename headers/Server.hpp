@@ -5,6 +5,7 @@
 #include <sys/socket.h>
 #include <cstring>
 #include <cstdlib>
+#include <cstdio>
 #include <ctime>
 #include <unistd.h>
 #include <map>
@@ -22,7 +23,14 @@
 #include <iomanip>
 
 #include "Client.hpp"
+#include "ClientTable.hpp"
 #include "Channel.hpp"
+#include "ChannelList.hpp"
+#include "WhoQuery.hpp"
+#include "Config.hpp"
+#include "Message.hpp"
+#include "EventLoop.hpp"
+#include "TimerWheel.hpp"
 
 class Channel;
 
@@ -37,8 +45,11 @@ enum serverRep {
 	RPL_AWAY = 301,
 	RPL_UNAWAY = 305,
 	RPL_NOWAWAY = 306,
+	RPL_WHOISUSER = 311,
+	RPL_WHOISSERVER = 312,
 	RPL_ENDOFWHOIS = 318,
 	RPL_ENDOFWHO = 315,
+	RPL_WHOISCHANNELS = 319,
 	RPL_LIST = 322,
 	RPL_LISTEND = 323,
 	RPL_CHANNELMODEIS = 324,
@@ -47,6 +58,7 @@ enum serverRep {
 	RPL_INVITING = 341,
 	RPL_WHOREPLY = 352,
 	RPL_NAMREPLY = 353,
+	RPL_WHOSPCRPL = 354,
 	RPL_ENDOFNAMES = 366,
 	RPL_ENDOFBANLIST = 368,
 	ERR_NOSUCHNICK = 401,
@@ -77,93 +89,164 @@ enum serverRep {
 	ERR_USERSDONTMATCH = 502
 };
 
+static const int REPLY_TABLE_SIZE = ERR_USERSDONTMATCH + 1;
+
+// Pre-rendered pieces of a numeric reply, the nickname and the
+// per-call arguments are copied in between
+struct ReplyTemplate {
+	std::string head; // ":<server> <code> "
+	std::string text; // fixed text after the optional token
+};
+
 static const int MAXCHANNELS = 9; // max number of channels a client can join
 static const int MAXTARGETS = 10; // max number of unique targets for commands with targets
+static const size_t NAMES_NICK_RESERVE = 30; // recipient nickname length a names chunk leaves room for
+static const size_t NAMES_CHUNK_MIN = 64;
+
+// Commands known to the dispatcher, in the order of Server::commands
+enum CommandId {
+	CMD_PASS,
+	CMD_NICK,
+	CMD_USER,
+	CMD_CAP,
+	CMD_PING,
+	CMD_PONG,
+	CMD_QUIT,
+	CMD_PRIVMSG,
+	CMD_NOTICE,
+	CMD_JOIN,
+	CMD_INVITE,
+	CMD_KICK,
+	CMD_TOPIC,
+	CMD_PART,
+	CMD_MODE,
+	CMD_NAMES,
+	CMD_LIST,
+	CMD_AWAY,
+	CMD_WHO,
+	CMD_WHOIS,
+	CMD_COUNT
+};
+
+// Client states a command is accepted in
+enum CommandState {
+	CMD_UNREGISTERED = 0b01,
+	CMD_REGISTERED = 0b10
+};
 
 class Server {
 public:
-	typedef std::map<std::string, void (Server::*)(int,
-												   const std::vector<std::string> &)> Cmd;
-	typedef std::map<std::string, void (Server::*)(int,
-												   const std::vector<std::string> &)>::iterator CmdIterator;
-	typedef std::map<char, bool (Server::*)(char, const std::string &,
-											Channel *, int)> ModeHandler;
-	typedef std::map<char, bool (Server::*)(char, const std::string &,
-											Channel *,
-											int)>::iterator ModeHandlerIterator;
+	typedef void (Server::*CommandHandler)(int, const Message &);
+	typedef bool (Server::*ModeHandler)(char, const std::string &,
+										Channel *, int);
+	typedef std::map<std::string, Channel *> ChannelMap; // keyed by folded name
+	struct Command {
+		const char *name;
+		CommandHandler handler;
+		unsigned int states; // CommandState bits
+	};
 	Server() {};
-	Server(int port, const std::string &password);
+	Server(int port, const std::string &password, const Config &config);
 	~Server();
 	static std::string uncapitalizeString(const std::string &input);
 
 	void run();
 private:
-	std::map<int, std::string> _serverMessages;
+	std::vector<ReplyTemplate> _replies; // indexed by serverRep
+	PayloadRef _capLs;
 	std::string getNick(int fd);
-	std::string getNickAndHostname(int fd);
-	Client &getClient(int fd);
+	const std::string &getPrefix(int fd);
 	int socketFd;
 	time_t start;
 	sockaddr_in address;
 	std::string _password;
 	std::string serverName;
 	std::string serverVersion;
-	std::vector<pollfd> pollFds;
-	std::map<int, Client *> clients;
-	std::vector<Channel *> _channels;
-	char _buffer[1024];
-	Cmd cmd;
-	ModeHandler channelMode;
-
-	std::map<std::string, std::string> users;
-	void initCmd();
+	Config _config;
+	EventLoop *_loop;
+	std::vector<IoReady> _ready;
+	std::vector<int> _writers; // clients that queued output since the last iteration
+	TimerWheel _timers;
+	std::vector<Timer *> _expired;
+	unsigned long _now; // ms timestamp of the current loop iteration
+	ClientTable clients;
+	ChannelMap _channels;
+	ChannelDirectory _directory; // every channel, ordered for LIST
+	std::vector<ListPager> _listings; // LIST replies waiting for their client's output to drain
+	std::vector<WhoPager> _whoPagers; // the same for WHO
+	static const Command commands[CMD_COUNT];
+	ModeHandler channelMode[256]; // indexed by mode character, NULL when unknown
+	std::map<std::string, Client *> _nicknames; // folded nickname -> registered client
+	std::set<std::pair<std::string, std::string> > _hosts; // (folded host, folded nickname) of registered clients
+	unsigned int _epoch; // stamped on the clients reached by the current neighbour walk
+	std::vector<int> _neighbours; // result of the last neighbour walk, reused
 	void initChannelMode();
-	void initServerMessages();
+	void initReplies();
 	Client *findClient(const std::string &nickname);
 	Client *findClient(int fd);
+	void renameClient(Client *client, const std::string &nickname);
 	void addClient(int clientSocket, std::string clientHostname);
 	void removeClient(int clientSocket);
+	void disconnectClient(int fd, const std::string &reason);
+	void startTimer(Client *client, TimerKind kind, unsigned long delayMs);
+	void expireTimers();
+	void handleTimer(Timer *timer);
 	void listenPort() const;
 	std::pair<int, std::string> acceptConnection();
-	bool parsBuffer(int fd);
-	bool registrationProcess(int fd, std::vector<std::string> &tokens);
+	void acceptConnections();
+	std::string peerHostname(int fd);
+	bool parsLine(int fd, const char *line, size_t length);
 	bool checkRegistration(int fd);
-	bool handleCommand(int fd, const std::string &command,
-					   const std::vector<std::string> &params);
-	void processCmd(int fd, std::vector<std::string> &tokens);
+	static const Command *findCommand(const Slice &name);
 	bool verifyNickname(int fd, const std::string &arg);
 	bool verifyPassword(int fd, const std::string &arg);
 	bool verifyUsername(int fd, const std::string &arg);
 	void serverSendReply(int fd, const std::string &token, serverRep id,
 						 const std::string &reply);
 	void serverSendError(int fd, const std::string &token, serverRep id);
+	PayloadRef formatReply(int fd, serverRep id, const std::string &token,
+						   const std::string &reply);
+	void sendRegistrationBurst(int fd);
+	PayloadRef formatNotification(const std::string &prefix,
+								  const std::string &command,
+								  const std::string &parameters);
 	void serverSendNotification(int fd, const std::string &prefix,
 								const std::string &command,
 								const std::string &parameters);
 	void
-	serverSendNotification(const std::set<int> &fds, const std::string &prefix,
+	serverSendNotification(const std::vector<int> &fds, const std::string &prefix,
 						   const std::string &command,
 						   const std::string &parameters);
+	void serverSendNotification(const Channel *channel, const std::string &prefix,
+								const std::string &command,
+								const std::string &parameters,
+								int exceptFd = -1);
 	void serverSendMessage(int fd, const std::string &message);
+	void serverSendMessage(int fd, const PayloadRef &message);
 
 	// Commands
-	void processPrivmsg(int fd, const std::vector<std::string> &tokens);
-	void processJoin(int fd, const std::vector<std::string> &tokens);
-	void processInvite(int fd, const std::vector<std::string> &tokens);
-	void processKick(int fd, const std::vector<std::string> &tokens);
-	void processTopic(int fd, const std::vector<std::string> &tokens);
-	void processPart(int fd, const std::vector<std::string> &tokens);
-	void processMode(int fd, const std::vector<std::string> &tokens);
-	void processChannelMode(int fd, const std::vector<std::string> &tokens);
-	void processUserMode(int fd, const std::vector<std::string> &tokens);
-	void processNames(int fd, const std::vector<std::string> &tokens);
-	void processList(int fd, const std::vector<std::string> &tokens);
-	void processPing(int fd, const std::vector<std::string> &tokens);
-	void processAway(int fd, const std::vector<std::string> &tokens);
-	void processNick(int fd, const std::vector<std::string> &tokens);
-	void processQuit(int fd, const std::vector<std::string> &tokens);
-	void processWho(int fd, const std::vector<std::string> &tokens);
-	void processWhois(int fd, const std::vector<std::string> &tokens);
+	void processPass(int fd, const Message &message);
+	void processUser(int fd, const Message &message);
+	void processCap(int fd, const Message &message);
+	void processPrivmsg(int fd, const Message &message);
+	void processJoin(int fd, const Message &message);
+	void processInvite(int fd, const Message &message);
+	void processKick(int fd, const Message &message);
+	void processTopic(int fd, const Message &message);
+	void processPart(int fd, const Message &message);
+	void processMode(int fd, const Message &message);
+	void processChannelMode(int fd, const Message &message);
+	void processUserMode(int fd, const Message &message);
+	void processNames(int fd, const Message &message);
+	void processList(int fd, const Message &message);
+	void processPing(int fd, const Message &message);
+	void processAway(int fd, const Message &message);
+	void processNick(int fd, const Message &message);
+	void processPong(int fd, const Message &message);
+	void processQuit(int fd, const Message &message);
+	void notifyQuit(int fd, const std::string &reason);
+	void processWho(int fd, const Message &message);
+	void processWhois(int fd, const Message &message);
 	bool handleModeT(char set, const std::string &parameter, Channel *channel,
 					 int fd);
 	bool handleModeI(char set, const std::string &parameter, Channel *channel,
@@ -177,29 +260,36 @@ private:
 	bool handleModeB(char set, const std::string &parameter, Channel *channel,
 					 int fd);
 	void addChannel(Channel *channel);
-	void removeChannel(const std::string &channelName);
+	void removeChannel(Channel *channel);
 	void removeClientFromChannel(int fd, Channel *channel);
+	const std::vector<int> &channelNeighbours(Client *client, bool includeSelf);
+	void inviteClient(Client *client, Channel *channel);
 	Channel *findChannel(const std::string &name);
-	std::vector<Channel *> findChannels(std::queue<std::string> names);
+	Channel *findFoldedChannel(const std::string &foldedName);
+	std::vector<Channel *> findChannels(const std::vector<std::string> &names);
 	bool isValidChannelName(const std::string &name);
-	void joinExistingChannel(int fd, Channel *channel, std::string password);
-	void createAndJoinNewChannel(int fd, std::string channelName,
-								 std::string password);
-	void listChannels(int fd, std::vector<Channel *> &channels);
-	std::vector<std::string> getClientsWithoutChannels();
-	std::map<std::string, std::vector<std::string> >
-	getClientsOfChannels(int fd, std::vector<Channel *> channels);
-	std::vector<std::string> getAllChannelMembersNicks(const Channel *channel);
-	std::vector<std::string>
-	getVisibleChannelMembersNicks(const Channel *channel);
-	void sendData(size_t index);
-	size_t receiveData(size_t index);
-	void resetEvents(size_t index);
+	void joinExistingChannel(int fd, Channel *channel, const std::string &password);
+	void createAndJoinNewChannel(int fd, const std::string &channelName,
+								 const std::string &password);
+	void updateDirectory(Channel *channel, size_t previousCount);
+	void startListing(int fd, const ListFilter &filter);
+	bool listNextPage(ListPager &pager);
+	void resumePagers();
+	bool pagersReady();
+	bool outputDrained(Client *client);
+	void sendListEntry(int fd, const Channel *channel);
+	size_t namesLimit(const std::string &token) const;
+	void sendNames(int fd, const Channel *channel);
+	void sendNamesChunks(int fd, const std::string &token, const NamesList &names);
+	void sendNamesWithoutChannel(int fd);
+	void sendData(int fd);
+	void flushWriters();
+	void receiveData(int fd);
+	bool processInput(Client *client);
 	static std::string
-	mergeTokensToString(const std::vector<std::string> &tokens,
-						bool removeColon);
+	mergeTokensToString(const std::vector<std::string> &tokens);
 	void sendJoinNotificationsAndReplies(int fd, const Channel *channel);
-	bool checkPmTokens(int fd, const std::vector<std::string> &tokens);
+	bool checkPmTokens(int fd, const Message &message);
 	void
 	sendPmToChan(int fd, const std::string &message, const std::string &prefix,
 				 const std::string &targetName,
@@ -208,16 +298,22 @@ private:
 	sendPmToUser(int fd, const std::string &message, const std::string &prefix,
 				 const std::string &targetName,
 				 const std::string &command);
-	static std::queue<std::string>
-	split(const std::string &src, char delimiter, bool unique);
+	static void split(const std::string &src, char delimiter, bool unique,
+					  std::vector<std::string> &tokens);
 	bool modeParameterNeeded(char set, char mode);
 	static bool isValidName(const std::string &name);
-	std::string paddDigits(int i);
 	static bool isNum(const std::string &str);
 	static bool isBitMask(const std::string &str);
 	static Mode getBitMode(const std::string str);
 	std::pair<std::string, std::string>
-		takeFullClientInfo(Client *client, Channel *channel);
+		takeFullClientInfo(Client *client, const Channel *channel);
+	void indexHost(Client *client, bool add);
+	void startWho(int fd, const WhoQuery &query);
+	bool whoNextPage(WhoPager &pager);
+	bool whoMatches(const WhoQuery &query, Client *client);
+	bool visibleTo(Client *client, int fd, const WhoQuery &query);
+	void sendWhoReply(int fd, const WhoQuery &query, Client *client,
+					  const Channel *channel);
 };
 
 #endif
@@ -0,0 +1,55 @@
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <vector>
+
+static const int WHEEL_BITS = 6;
+static const int WHEEL_SIZE = 1 << WHEEL_BITS; // slots per level
+static const int WHEEL_MASK = WHEEL_SIZE - 1;
+static const int WHEEL_LEVELS = 4; // 64^4 ticks of range
+
+enum TimerKind {
+	TIMER_REGISTRATION, // connection has to finish registration before it fires
+	TIMER_IDLE, // no traffic seen for a while: time to send a PING
+	TIMER_PONG // PING sent: an answer is expected before it fires
+};
+
+// Intrusive timer entry, embedded in the object it belongs to
+struct Timer {
+	Timer *next;
+	Timer *prev;
+	unsigned long expires; // tick at which the timer fires
+	int fd;
+	TimerKind kind;
+
+	Timer();
+	bool pending() const;
+};
+
+// Hierarchical timing wheel: O(1) schedule and cancel, expiry cost
+// proportional to the timers that actually fire.
+class TimerWheel {
+	private:
+		Timer _slots[WHEEL_LEVELS][WHEEL_SIZE]; // list heads
+		unsigned long _originMs;
+		unsigned long _tickMs;
+		unsigned long _tick; // next tick to be processed
+		size_t _count;
+
+		static void link(Timer &head, Timer &timer);
+		static void unlink(Timer &timer);
+		void place(Timer &timer);
+		void cascade(int level);
+
+	public:
+		explicit TimerWheel(unsigned long tickMs = 100);
+
+		static unsigned long now();
+		void schedule(Timer &timer, unsigned long delayMs);
+		void cancel(Timer &timer);
+		void advance(unsigned long nowMs, std::vector<Timer *> &expired);
+		// milliseconds until the wheel needs to advance again, -1 when no timer is pending
+		int nextTimeout(unsigned long nowMs) const;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef URINGLOOP_HPP
+#define URINGLOOP_HPP
+
+#ifdef __linux__
+
+#include <string>
+#include <linux/io_uring.h>
+#include "EventLoop.hpp"
+
+static const unsigned int URING_ENTRIES = 1024; // submission queue size
+static const unsigned int URING_BUFFERS = 256; // provided receive buffers, power of two
+static const unsigned int URING_BUFFER_SIZE = 4096;
+
+// Completion backend: the ring performs accept, recv and send itself.
+// Accepted sockets are reported as EV_ACCEPT, received bytes as EV_READ with
+// data/length pointing into a provided buffer valid until the next wait().
+class UringLoop : public EventLoop {
+	private:
+		struct Connection {
+			unsigned int generation; // tags completions, stale ones are dropped after a close
+			bool receiving;
+			bool closing;
+			std::string sending; // bytes owned by the in-flight send
+			size_t sendOffset;
+			std::string staged; // bytes queued while a send is in flight
+
+			Connection();
+		};
+
+		int _ringFd;
+		int _listenFd;
+		void *_ringMap; // submission and completion rings share one mapping
+		size_t _ringMapSize;
+		io_uring_sqe *_sqes;
+		size_t _sqesSize;
+		unsigned int _sqEntries;
+		unsigned int *_sqHead;
+		unsigned int *_sqTail;
+		unsigned int _sqMask;
+		unsigned int *_sqArray;
+		unsigned int _sqLocalTail;
+		unsigned int *_cqHead;
+		unsigned int *_cqTail;
+		unsigned int _cqMask;
+		io_uring_cqe *_cqes;
+		io_uring_buf *_bufRing; // the ring tail overlays the resv field of the first entry
+		size_t _bufRingSize;
+		char *_buffers;
+		unsigned short _bufTail;
+		std::vector<unsigned short> _usedBuffers; // handed out with the last batch of events
+		std::vector<Connection *> _connections; // indexed by fd, stable addresses for in-flight sends
+		std::vector<int> _pendingSends; // sockets with staged bytes to submit
+		std::vector<int> _pendingRecvs; // sockets whose multishot recv has to be re-armed
+
+		void setup();
+		void probe();
+		void setupBuffers();
+		void teardown();
+		io_uring_sqe *getSqe();
+		void submit(unsigned int waitFor, int timeoutMs);
+		Connection &connection(int fd);
+		void armAccept();
+		void armRecv(int fd);
+		void submitSend(int fd);
+		void cancel(int fd, unsigned int op);
+		void provideBuffer(unsigned short bid);
+		void complete(const io_uring_cqe &cqe, std::vector<IoReady> &ready);
+		void releaseConnection(int fd);
+
+	public:
+		UringLoop();
+		~UringLoop();
+
+		const char *name() const;
+		bool edgeTriggered() const;
+		bool completionBased() const;
+		void add(int fd, unsigned int events);
+		void modify(int fd, unsigned int events);
+		void remove(int fd);
+		void closeDescriptor(int fd);
+		void send(int fd, const char *data, size_t length);
+		size_t pendingOutput(int fd) const;
+		void wait(std::vector<IoReady> &ready, int timeoutMs);
+};
+
+#endif
+
+#endif
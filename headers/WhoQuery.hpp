@@ -0,0 +1,57 @@
+#ifndef WHOQUERY_HPP
+#define WHOQUERY_HPP
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "ClientTable.hpp"
+#include "Mask.hpp"
+
+static const size_t WHO_PAGE_SIZE = 64; // replies queued each time the client's output drains
+static const size_t WHO_SCAN_LIMIT = 1024; // candidates a page looks at before yielding to the loop
+
+// Fields a WHO mask is matched against, selected by the flags before '%'
+enum WhoMatch {
+	WHO_MATCH_NICK = 0b00001, // n
+	WHO_MATCH_USER = 0b00010, // u
+	WHO_MATCH_HOST = 0b00100, // h, i
+	WHO_MATCH_REALNAME = 0b01000, // r
+	WHO_MATCH_SERVER = 0b10000, // s
+	WHO_MATCH_ALL = 0b11111
+};
+
+// WHOX fields of RPL_WHOSPCRPL, in the order they are written
+static const char WHOX_FIELDS[] = "tcuihsnfdlaor";
+
+// Where the candidates of a WHO come from
+enum WhoSource {
+	WHO_CHANNEL, // joined members of one channel
+	WHO_NICKS, // nickname index, from the mask prefix when matching nicknames only
+	WHO_HOSTS // host index, from the mask prefix when matching hosts only
+};
+
+// WHO <mask> [<flags>][%<fields>[,<token>]]
+struct WhoQuery {
+	std::string target; // echoed by RPL_ENDOFWHO
+	Mask mask;
+	unsigned int match; // WhoMatch bits
+	std::string fields; // WHOX letters requested, empty for RPL_WHOREPLY
+	std::string token;
+	bool operatorsOnly; // 'o': no server operators exist, nothing matches
+
+	WhoQuery();
+	void parse(const std::string &target, const std::string &options);
+};
+
+// A WHO walking its source, resumed page by page after the last key visited
+struct WhoPager {
+	ClientHandle client;
+	WhoQuery query;
+	WhoSource source;
+	std::string channel; // folded name, WHO_CHANNEL
+	std::pair<std::string, std::string> cursor; // last index key visited
+	std::vector<ClientHandle> members; // joined members when the WHO started, WHO_CHANNEL
+	size_t position; // next entry of members
+};
+
+#endif
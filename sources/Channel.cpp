@@ -1,7 +1,13 @@
 #include "../headers/Channel.hpp"
 #include "../headers/Server.hpp"
 
-Channel::Channel(const std::string &name, std::string &password) {
+Channel::Channel(const std::string &name, const std::string &password, size_t namesLimit)
+	: _memberCount(0),
+	  _limitMembers(0),
+	  _created(time(NULL)),
+	  _topicTime(0),
+	  _names(namesLimit),
+	  _visibleNames(namesLimit) {
 	_name = Server::uncapitalizeString(name);
 	_password = password;
 	_topic = "";
@@ -54,16 +60,37 @@ std::string Channel::getModeStringWithParameters() const {
 	return modeString;
 }
 
-const std::set<int> &Channel::getMemberFds() const {
-	return _memberFds;
+const std::vector<Member> &Channel::getMembers() const {
+	return _members;
+}
+
+size_t Channel::getMemberCount() const {
+	return _memberCount;
 }
 
 int Channel::getLimitMembers() const {
 	return _limitMembers;
 }
 
+const NamesList &Channel::getNames() const {
+	return _names;
+}
+
+const NamesList &Channel::getVisibleNames() const {
+	return _visibleNames;
+}
+
+time_t Channel::getCreationTime() const {
+	return _created;
+}
+
+time_t Channel::getTopicTime() const {
+	return _topicTime;
+}
+
 void Channel::setTopic(const std::string &topic) {
 	_topic = topic;
+	_topicTime = time(NULL);
 }
 
 void Channel::setPassword(const std::string &password) {
@@ -95,49 +122,234 @@ bool Channel::isModeSet(unsigned int mode) const {
 }
 
 
-void Channel::addMember(int clientFd) {
-	_memberFds.insert(clientFd);
+// Membership entries
+
+int Channel::position(int clientFd) const {
+	if (!_positions.empty()) {
+		if (clientFd < 0 || clientFd >= static_cast<int>(_positions.size())) {
+			return -1;
+		}
+		return _positions[clientFd];
+	}
+	for (size_t i = 0; i < _members.size(); i++) {
+		if (_members[i].fd == clientFd) {
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
+
+bool Channel::hasFlag(int clientFd, unsigned char flag) const {
+	int index = position(clientFd);
+	return index >= 0 && (_members[index].flags & flag);
+}
+
+bool Channel::setFlag(int clientFd, unsigned char flag) {
+	int index = position(clientFd);
+	if (index < 0) {
+		Member member;
+		member.fd = clientFd;
+		member.flags = 0;
+		member.namesChunk = 0;
+		member.visibleChunk = 0;
+		index = static_cast<int>(_members.size());
+		_members.push_back(member);
+		if (_positions.empty() && _members.size() >= MEMBER_INDEX_THRESHOLD) {
+			for (size_t i = 0; i < _members.size(); i++) {
+				if (_members[i].fd >= static_cast<int>(_positions.size())) {
+					_positions.resize(_members[i].fd + 1, -1);
+				}
+				_positions[_members[i].fd] = static_cast<int>(i);
+			}
+		} else if (!_positions.empty()) {
+			if (clientFd >= static_cast<int>(_positions.size())) {
+				_positions.resize(clientFd + 1, -1);
+			}
+			_positions[clientFd] = index;
+		}
+	}
+	if (_members[index].flags & flag) {
+		return false;
+	}
+	if (flag == MEMBER_JOINED) {
+		_memberCount++;
+	}
+	_members[index].flags |= flag;
+	return true;
+}
+
+bool Channel::clearFlag(int clientFd, unsigned char flag) {
+	int index = position(clientFd);
+	if (index < 0 || !(_members[index].flags & flag)) {
+		return false;
+	}
+	if (flag == MEMBER_JOINED) {
+		_memberCount--;
+		unlistName(_members[index]);
+		_members[index].flags &= ~MEMBER_INVISIBLE;
+	}
+	_members[index].flags &= ~flag;
+	if (!_members[index].flags) {
+		eraseEntry(index);
+	}
+	compactNames();
+	return true;
+}
+
+void Channel::eraseEntry(int index) {
+	if (_members[index].flags & MEMBER_JOINED) {
+		_memberCount--;
+		unlistName(_members[index]);
+	}
+	if (!_positions.empty()) {
+		_positions[_members[index].fd] = -1;
+	}
+	// the last entry takes the freed place
+	_members[index] = _members.back();
+	_members.pop_back();
+	if (!_positions.empty() && index < static_cast<int>(_members.size())) {
+		_positions[_members[index].fd] = index;
+	}
+}
+
+// Names lists
+
+std::string Channel::nameEntry(const Member &member) {
+	if (member.flags & MEMBER_OPERATOR) {
+		return "@" + member.nickname;
+	}
+	return member.nickname;
+}
+
+void Channel::listName(Member &member) {
+	std::string entry = nameEntry(member);
+	member.namesChunk = _names.insert(entry);
+	if (!(member.flags & MEMBER_INVISIBLE)) {
+		member.visibleChunk = _visibleNames.insert(entry);
+	}
+}
+
+void Channel::unlistName(const Member &member) {
+	std::string entry = nameEntry(member);
+	_names.erase(member.namesChunk, entry);
+	if (!(member.flags & MEMBER_INVISIBLE)) {
+		_visibleNames.erase(member.visibleChunk, entry);
+	}
+}
+
+// packs the chunks again once departures left them mostly empty
+void Channel::compactNames() {
+	if (!_names.fragmented() && !_visibleNames.fragmented()) {
+		return;
+	}
+	_names.clear();
+	_visibleNames.clear();
+	for (size_t i = 0; i < _members.size(); i++) {
+		if (_members[i].flags & MEMBER_JOINED) {
+			listName(_members[i]);
+		}
+	}
+}
+
+void Channel::addMember(const Client *client) {
+	int clientFd = client->getSocket();
+	if (!setFlag(clientFd, MEMBER_JOINED)) {
+		return;
+	}
+	Member &member = _members[position(clientFd)];
+	member.nickname = client->getNickname();
+	if (client->activeMode(INVISIBLE)) {
+		member.flags |= MEMBER_INVISIBLE;
+	}
+	listName(member);
 }
 
 void Channel::removeMember(int clientFd) {
-	removeInvited(clientFd);
-	removeOperator(clientFd);
-	_memberFds.erase(clientFd);
+	int index = position(clientFd);
+	if (index >= 0) {
+		eraseEntry(index);
+		compactNames();
+	}
+}
+
+bool Channel::hasMember(int clientFd) const {
+	return hasFlag(clientFd, MEMBER_JOINED);
 }
 
-bool Channel::hasMember(int clientFd) {
-	return _memberFds.find(clientFd) != _memberFds.end();
+void Channel::renameMember(int clientFd, const std::string &nickname) {
+	int index = position(clientFd);
+	if (index < 0 || !(_members[index].flags & MEMBER_JOINED)) {
+		return;
+	}
+	unlistName(_members[index]);
+	_members[index].nickname = nickname;
+	listName(_members[index]);
+	compactNames();
 }
 
-bool Channel::authMember(int clientFd, std::string &password) {
+void Channel::setMemberInvisible(int clientFd, bool invisible) {
+	int index = position(clientFd);
+	if (index < 0 || !(_members[index].flags & MEMBER_JOINED)
+		|| invisible == static_cast<bool>(_members[index].flags & MEMBER_INVISIBLE)) {
+		return;
+	}
+	Member &member = _members[index];
+	if (invisible) {
+		_visibleNames.erase(member.visibleChunk, nameEntry(member));
+		member.flags |= MEMBER_INVISIBLE;
+	} else {
+		member.flags &= ~MEMBER_INVISIBLE;
+		member.visibleChunk = _visibleNames.insert(nameEntry(member));
+	}
+	compactNames();
+}
+
+bool Channel::authMember(const Client *client, const std::string &password) {
 	if (password != _password) {
 		return false;
 	}
-	removeInvited(clientFd);
-	addMember(clientFd);
+	removeInvited(client->getSocket());
+	addMember(client);
 	return true;
 }
 
+// a joined member's entry moves to the end of the lists with its new prefix
 bool Channel::addOperator(int clientFd) {
-	return _operatorFds.insert(clientFd).second;
+	int index = position(clientFd);
+	if (index >= 0 && (_members[index].flags & MEMBER_JOINED) && !(_members[index].flags & MEMBER_OPERATOR)) {
+		unlistName(_members[index]);
+		_members[index].flags |= MEMBER_OPERATOR;
+		listName(_members[index]);
+		compactNames();
+		return true;
+	}
+	return setFlag(clientFd, MEMBER_OPERATOR);
 }
 
 bool Channel::removeOperator(int clientFd) {
-	return _operatorFds.erase(clientFd);
+	int index = position(clientFd);
+	if (index >= 0 && (_members[index].flags & MEMBER_JOINED) && (_members[index].flags & MEMBER_OPERATOR)) {
+		unlistName(_members[index]);
+		_members[index].flags &= ~MEMBER_OPERATOR;
+		listName(_members[index]);
+		compactNames();
+		return true;
+	}
+	return clearFlag(clientFd, MEMBER_OPERATOR);
 }
 
 bool Channel::hasOperator(int clientFd) const {
-	return _operatorFds.find(clientFd) != _operatorFds.end();
+	return hasFlag(clientFd, MEMBER_OPERATOR);
 }
 
 void Channel::addInvited(int clientFd) {
-	_invitedFds.insert(clientFd);
+	setFlag(clientFd, MEMBER_INVITED);
 }
 
 void Channel::removeInvited(int clientFd) {
-	_invitedFds.erase(clientFd);
+	clearFlag(clientFd, MEMBER_INVITED);
 }
 
-bool Channel::hasInvited(int clientFd) {
-	return _invitedFds.find(clientFd) != _invitedFds.end();
-}
\ No newline at end of file
+bool Channel::hasInvited(int clientFd) const {
+	return hasFlag(clientFd, MEMBER_INVITED);
+}
@@ -0,0 +1,103 @@
+#include "../headers/ChannelList.hpp"
+#include <cstdlib>
+#include <cerrno>
+
+bool DirectoryOrder::operator()(const DirectoryKey &a, const DirectoryKey &b) const {
+	if (a.first != b.first) {
+		return a.first > b.first;
+	}
+	return a.second < b.second;
+}
+
+ListFilter::ListFilter()
+	: moreThan(0),
+	  lessThan(0),
+	  createdBefore(-1),
+	  createdAfter(-1),
+	  topicBefore(-1),
+	  topicAfter(-1) {
+}
+
+static bool parseCount(const std::string &digits, long &value) {
+	if (digits.empty() || digits.find_first_not_of("0123456789") != std::string::npos) {
+		return false;
+	}
+	errno = 0;
+	value = strtol(digits.c_str(), NULL, 10);
+	return errno == 0;
+}
+
+bool ListFilter::add(const std::string &condition) {
+	long value;
+	if (condition.size() > 1 && (condition[0] == '>' || condition[0] == '<')) {
+		if (!parseCount(condition.substr(1), value)) {
+			return false;
+		}
+		if (condition[0] == '>') {
+			moreThan = value;
+		} else {
+			lessThan = value;
+		}
+		return true;
+	}
+	if (condition.size() > 2 && (condition[0] == 'C' || condition[0] == 'T')
+		&& (condition[1] == '>' || condition[1] == '<')) {
+		if (!parseCount(condition.substr(2), value)) {
+			return false;
+		}
+		long &bound = condition[0] == 'C'
+					  ? (condition[1] == '>' ? createdBefore : createdAfter)
+					  : (condition[1] == '>' ? topicBefore : topicAfter);
+		bound = value * 60;
+		return true;
+	}
+	if (condition.size() > 2 && condition[0] == 'T' && condition[1] == ':') {
+		topicMasks.push_back(Mask(condition.substr(2)));
+		return true;
+	}
+	if (condition.size() > 1 && condition[0] == '!') {
+		excludedMasks.push_back(Mask(condition.substr(1)));
+		return true;
+	}
+	if (condition.find_first_of("*?") != std::string::npos) {
+		masks.push_back(Mask(condition));
+		return true;
+	}
+	return false;
+}
+
+static bool matchesAny(const std::vector<Mask> &masks, const std::string &text) {
+	for (std::vector<Mask>::const_iterator it = masks.begin(); it != masks.end(); ++it) {
+		if (it->match(text)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ListFilter::matches(const Channel &channel, time_t now) const {
+	size_t members = channel.getMemberCount();
+	if (members <= moreThan || (lessThan && members >= lessThan)) {
+		return false;
+	}
+	long age = static_cast<long>(now - channel.getCreationTime());
+	if ((createdBefore >= 0 && age <= createdBefore) || (createdAfter >= 0 && age >= createdAfter)) {
+		return false;
+	}
+	if (topicBefore >= 0 || topicAfter >= 0 || !topicMasks.empty()) {
+		if (channel.getTopic().empty()) {
+			return false;
+		}
+		long topicAge = static_cast<long>(now - channel.getTopicTime());
+		if ((topicBefore >= 0 && topicAge <= topicBefore) || (topicAfter >= 0 && topicAge >= topicAfter)) {
+			return false;
+		}
+		if (!topicMasks.empty() && !matchesAny(topicMasks, channel.getTopic())) {
+			return false;
+		}
+	}
+	if (!masks.empty() && !matchesAny(masks, channel.getName())) {
+		return false;
+	}
+	return excludedMasks.empty() || !matchesAny(excludedMasks, channel.getName());
+}
@@ -3,48 +3,78 @@
 
 Client::Client(int socket, std::string hostname)
 	: _socketFd(socket),
-	  _logged(false),
-	  _registered(false),
+	  _state(0),
 	  _modes(0),
+	  _sendHead(0),
+	  _sendOffset(0),
+	  _recvStart(0),
+	  _recvEnd(0),
+	  _mark(0),
+	  _lastActivity(0),
+	  _pingSent(0),
 	  _hostname(hostname),
-	  _recvBuffer(""),
-	  _awayMessage(""),
-	  _quit(false) {
+	  _profile(NULL) {
+	_timer.fd = socket;
+	updatePrefix();
 }
 
 Client::~Client() {
+	delete _profile;
+}
+
+ClientProfile &Client::profile() {
+	if (!_profile) {
+		_profile = new ClientProfile;
+	}
+	return *_profile;
+}
+
+void Client::setState(unsigned char flag, bool set) {
+	if (set) {
+		_state |= flag;
+	} else {
+		_state &= ~flag;
+	}
 }
 
 void Client::setNickname(const std::string &nickname) {
 	_nickname = Server::uncapitalizeString(nickname);
+	updatePrefix();
 }
 
 void Client::setUsername(const std::string &username) {
 	Client::_username = username;
+	updatePrefix();
 }
 
-void Client::setLog() {
-	Client::_logged = true;
+void Client::updatePrefix() {
+	_prefix.clear();
+	_prefix.reserve(_nickname.size() + _username.size() + _hostname.size() + 3);
+	_prefix.append(_nickname).append("!~").append(_username).append("@").append(_hostname);
 }
 
-void Client::setRegistration() {
-	Client::_registered = true;
+const std::string &Client::getPrefix() const {
+	return _prefix;
 }
 
-void Client::setPassword(const std::string &password) {
-	Client::_password = password;
+void Client::setLog() {
+	setState(CLIENT_LOGGED, true);
+}
+
+void Client::setRegistration() {
+	setState(CLIENT_REGISTERED, true);
 }
 
 void Client::setRealName(const std::string &real_name) {
-	_realName = real_name;
+	profile().realName = real_name;
 }
 
 void Client::setAwayMessage(const std::string &away) {
-	Client::_awayMessage = away;
+	profile().awayMessage = away;
 }
 
 void Client::setQuit(bool quit) {
-	Client::_quit = quit;
+	setState(CLIENT_QUIT, quit);
 }
 
 const std::string &Client::getNickname() const {
@@ -56,23 +86,19 @@ const std::string &Client::getUsername() const {
 }
 
 bool Client::isRegistered() const {
-	return _registered;
+	return _state & CLIENT_REGISTERED;
 }
 
 bool Client::isLogged() const {
-	return _logged;
+	return _state & CLIENT_LOGGED;
 }
 
 int Client::getSocket() const {
 	return _socketFd;
 }
 
-const std::string &Client::getPassword() const {
-	return _password;
-}
-
 std::string Client::getRealName() const {
-	return _realName;
+	return _profile ? _profile->realName : std::string();
 }
 
 const std::string &Client::getHostname() const {
@@ -80,60 +106,209 @@ const std::string &Client::getHostname() const {
 }
 
 bool Client::isQuit() const {
-	return _quit;
+	return _state & CLIENT_QUIT;
 }
 
-void Client::pushSendQueue(std::string send) {
-	_sendQueue.push(send);
+void Client::pushSendQueue(const PayloadRef &send) {
+	_sendQueue.push_back(send);
 }
 
-std::string Client::popSendQueue() {
-	std::string ret(_sendQueue.front());
-	_sendQueue.pop();
-	return ret;
+// gathers the queued messages, starting at the unsent part of the head one
+int Client::fillSendVector(iovec *iov, int maxCount, size_t &bytes) const {
+	int count = 0;
+	bytes = 0;
+	std::vector<PayloadRef>::const_iterator it = _sendQueue.begin() + _sendHead;
+	for (; it != _sendQueue.end() && count < maxCount; ++it, ++count) {
+		size_t offset = count == 0 ? _sendOffset : 0;
+		iov[count].iov_base = const_cast<char *>(it->data() + offset);
+		iov[count].iov_len = it->length() - offset;
+		bytes += iov[count].iov_len;
+	}
+	return count;
+}
+
+bool Client::isPendingWrite() const {
+	return _state & CLIENT_PENDING_WRITE;
+}
+
+void Client::setPendingWrite(bool pending) {
+	setState(CLIENT_PENDING_WRITE, pending);
+}
+
+void Client::consumeSendQueue(size_t bytes) {
+	while (bytes > 0 && _sendHead < _sendQueue.size()) {
+		size_t remaining = _sendQueue[_sendHead].length() - _sendOffset;
+		if (bytes < remaining) {
+			_sendOffset += bytes;
+			return;
+		}
+		bytes -= remaining;
+		// dropping the reference now frees the payload once every recipient sent it
+		_sendQueue[_sendHead++] = PayloadRef();
+		_sendOffset = 0;
+	}
+	if (_sendHead == _sendQueue.size()) {
+		_sendHead = 0;
+		if (_sendQueue.capacity() > SEND_QUEUE_KEEP) {
+			std::vector<PayloadRef>().swap(_sendQueue);
+		} else {
+			_sendQueue.clear();
+		}
+	} else if (_sendHead >= SEND_QUEUE_KEEP && _sendHead * 2 >= _sendQueue.size()) {
+		// a slow reader: the sent half is dropped instead of growing forever
+		_sendQueue.erase(_sendQueue.begin(), _sendQueue.begin() + _sendHead);
+		_sendHead = 0;
+	}
 }
 
 bool Client::sendQueueEmpty() {
-	return _sendQueue.empty();
+	return _sendHead == _sendQueue.size();
+}
+
+// called once the socket is drained, idle connections then hold no receive memory
+void Client::releaseRecvBuffer() {
+	if (_recvStart == _recvEnd && !_recvBuffer.empty()) {
+		std::vector<char>().swap(_recvBuffer);
+		_recvStart = 0;
+		_recvEnd = 0;
+	}
 }
 
-void Client::appendRecvBuffer(std::string recv) {
-	_recvBuffer.append(recv);
+// returns where the next recv can write, with at least RECV_CHUNK bytes available
+char *Client::recvSpace(size_t &available) {
+	if (_recvEnd - _recvStart >= RECV_LINE_MAX) {
+		// no line feed in sight: drop what was buffered and skip up to the next one
+		_recvStart = 0;
+		_recvEnd = 0;
+		setState(CLIENT_RECV_DISCARDING, true);
+	}
+	if (_recvBuffer.size() - _recvEnd < RECV_CHUNK && _recvStart > 0) {
+		// moving the partial tail to the front
+		memmove(&_recvBuffer[0], &_recvBuffer[_recvStart], _recvEnd - _recvStart);
+		_recvEnd -= _recvStart;
+		_recvStart = 0;
+	}
+	if (_recvBuffer.size() - _recvEnd < RECV_CHUNK) {
+		_recvBuffer.resize(_recvEnd + RECV_CHUNK);
+	}
+	available = _recvBuffer.size() - _recvEnd;
+	return &_recvBuffer[_recvEnd];
 }
 
-std::string Client::getRecvBuffer() {
-	return _recvBuffer;
+void Client::recvCommit(size_t bytes) {
+	_recvEnd += bytes;
 }
 
-void Client::resetRecvBuffer() {
-	_recvBuffer.clear();
+void Client::appendRecvBuffer(const char *data, size_t length) {
+	while (length > 0) {
+		size_t available;
+		char *space = recvSpace(available);
+		size_t chunk = length < available ? length : available;
+		memcpy(space, data, chunk);
+		recvCommit(chunk);
+		data += chunk;
+		length -= chunk;
+	}
 }
 
-bool Client::isRecvBufferEmpty() {
-	return _recvBuffer.empty();
+// frames the next complete line in place, a partial tail stays buffered
+bool Client::nextLine(const char *&line, size_t &length) {
+	while (_recvStart < _recvEnd) {
+		char *start = &_recvBuffer[_recvStart];
+		char *lineFeed = static_cast<char *>(memchr(start, '\n', _recvEnd - _recvStart));
+		if (!lineFeed) {
+			return false;
+		}
+		_recvStart += lineFeed - start + 1;
+		if (_recvStart == _recvEnd) {
+			_recvStart = 0;
+			_recvEnd = 0;
+		}
+		if (_state & CLIENT_RECV_DISCARDING) {
+			setState(CLIENT_RECV_DISCARDING, false);
+			continue;
+		}
+		line = start;
+		length = lineFeed - start;
+		if (length > 0 && start[length - 1] == '\r') {
+			length--;
+		}
+		return true;
+	}
+	return false;
 }
 
 const std::string &Client::getAwayMessage() const {
-	return _awayMessage;
+	static const std::string none;
+	return _profile ? _profile->awayMessage : none;
 }
 
-const std::vector<std::string> &Client::getChannels() const {
+const std::vector<Channel *> &Client::getChannels() const {
 	return _channels;
 }
 
-void Client::addChannel(const std::string &channel) {
-	_channels.push_back(channel);
+const std::vector<Channel *> &Client::getInvites() const {
+	static const std::vector<Channel *> none;
+	return _profile ? _profile->invites : none;
 }
 
-void Client::removeChannel(const std::string &channel) {
-	for (std::vector<std::string>::iterator it = _channels.begin(); it != _channels.end(); ++it) {
-		if (*it == channel) {
-			_channels.erase(it);
-			break;
+// both lists are short, order does not matter so removal swaps in the last entry
+static void removeHandle(std::vector<Channel *> &channels, Channel *channel) {
+	for (size_t i = 0; i < channels.size(); i++) {
+		if (channels[i] == channel) {
+			channels[i] = channels.back();
+			channels.pop_back();
+			return;
 		}
 	}
 }
 
+void Client::addChannel(Channel *channel) {
+	_channels.push_back(channel);
+}
+
+void Client::removeChannel(Channel *channel) {
+	removeHandle(_channels, channel);
+}
+
+void Client::addInvite(Channel *channel) {
+	profile().invites.push_back(channel);
+}
+
+void Client::removeInvite(Channel *channel) {
+	if (_profile) {
+		removeHandle(_profile->invites, channel);
+	}
+}
+
+Timer &Client::getTimer() {
+	return _timer;
+}
+
+unsigned long Client::getLastActivity() const {
+	return _lastActivity;
+}
+
+void Client::setLastActivity(unsigned long now) {
+	_lastActivity = now;
+}
+
+unsigned long Client::getPingSent() const {
+	return _pingSent;
+}
+
+void Client::setPingSent(unsigned long now) {
+	_pingSent = now;
+}
+
+unsigned int Client::getMark() const {
+	return _mark;
+}
+
+void Client::setMark(unsigned int epoch) {
+	_mark = epoch;
+}
+
 std::string Client::returnModes() {
 	std::string fullModes;
 
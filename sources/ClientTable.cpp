@@ -0,0 +1,106 @@
+#include <new>
+#include "../headers/ClientTable.hpp"
+
+ClientHandle::ClientHandle() : fd(-1), generation(0) {
+}
+
+ClientHandle::ClientHandle(int fd, unsigned int generation)
+	: fd(fd), generation(generation) {
+}
+
+ClientTable::ClientTable(size_t capacity)
+	: _slab(NULL),
+	  _nextGeneration(1) {
+	if (capacity) {
+		_slab = static_cast<Client *>(::operator new(capacity * sizeof(Client)));
+	}
+	_slots.resize(capacity);
+	_free.reserve(capacity);
+	_fds.reserve(capacity);
+	// lowest slots are handed out first
+	for (size_t i = capacity; i > 0; i--) {
+		_slots[i - 1].generation = 0;
+		_slots[i - 1].fd = -1;
+		_slots[i - 1].position = 0;
+		_free.push_back(static_cast<int>(i - 1));
+	}
+}
+
+ClientTable::~ClientTable() {
+	while (!_fds.empty()) {
+		destroy(_fds.back());
+	}
+	::operator delete(_slab);
+}
+
+Client *ClientTable::create(int fd, const std::string &hostname) {
+	if (fd < 0 || _free.empty() || (*this)[fd]) {
+		return NULL;
+	}
+	if (fd >= static_cast<int>(_fdSlots.size())) {
+		_fdSlots.resize(fd + 1, -1);
+	}
+	int slot = _free.back();
+	_free.pop_back();
+	Client *client = new (&_slab[slot]) Client(fd, hostname);
+	_slots[slot].generation = _nextGeneration++;
+	if (!_nextGeneration) {
+		_nextGeneration = 1;
+	}
+	_slots[slot].fd = fd;
+	_slots[slot].position = _fds.size();
+	_fds.push_back(fd);
+	_fdSlots[fd] = slot;
+	return client;
+}
+
+void ClientTable::destroy(int fd) {
+	if (!(*this)[fd]) {
+		return;
+	}
+	int slot = _fdSlots[fd];
+	_slab[slot].~Client();
+	// the last live descriptor takes the freed position
+	size_t position = _slots[slot].position;
+	_fds[position] = _fds.back();
+	_slots[_fdSlots[_fds[position]]].position = position;
+	_fds.pop_back();
+	_slots[slot].generation = 0;
+	_slots[slot].fd = -1;
+	_fdSlots[fd] = -1;
+	_free.push_back(slot);
+}
+
+Client *ClientTable::operator[](int fd) const {
+	if (fd < 0 || fd >= static_cast<int>(_fdSlots.size()) || _fdSlots[fd] < 0) {
+		return NULL;
+	}
+	return &_slab[_fdSlots[fd]];
+}
+
+Client *ClientTable::find(const ClientHandle &handle) const {
+	Client *client = (*this)[handle.fd];
+	if (!client || _slots[_fdSlots[handle.fd]].generation != handle.generation) {
+		return NULL;
+	}
+	return client;
+}
+
+ClientHandle ClientTable::handle(int fd) const {
+	if (!(*this)[fd]) {
+		return ClientHandle();
+	}
+	return ClientHandle(fd, _slots[_fdSlots[fd]].generation);
+}
+
+const std::vector<int> &ClientTable::fds() const {
+	return _fds;
+}
+
+size_t ClientTable::size() const {
+	return _fds.size();
+}
+
+size_t ClientTable::capacity() const {
+	return _slots.size();
+}
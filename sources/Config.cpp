@@ -0,0 +1,73 @@
+#include <stdexcept>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#include "../headers/Config.hpp"
+
+Config::Config()
+	: backend(EventLoop::defaultBackend()),
+	  registrationTimeout(30),
+	  pingInterval(120),
+	  pingTimeout(60),
+	  acceptBatch(64),
+	  maxClients(1024),
+	  cpu(-1) {
+}
+
+static unsigned long parseNumber(const std::string &key, const std::string &value,
+								 unsigned long min = 1) {
+	std::istringstream iss(value);
+	unsigned long number;
+	if (value.empty() || value[0] == '-' || !(iss >> number) || !iss.eof() || number < min) {
+		throw std::runtime_error("Invalid value for " + key + ": " + value);
+	}
+	return number;
+}
+
+void Config::parseOption(const std::string &option) {
+	size_t equal = option.find('=');
+	if (option.compare(0, 2, "--") != 0 || equal == std::string::npos) {
+		throw std::runtime_error("Invalid option: " + option);
+	}
+	std::string key = option.substr(2, equal - 2);
+	std::string value = option.substr(equal + 1);
+	if (key == "backend") {
+		if (!EventLoop::parseBackend(value, backend)) {
+			throw std::runtime_error("Unknown event loop backend: " + value);
+		}
+	} else if (key == "register-timeout") {
+		registrationTimeout = parseNumber(key, value);
+	} else if (key == "ping-interval") {
+		pingInterval = parseNumber(key, value);
+	} else if (key == "ping-timeout") {
+		pingTimeout = parseNumber(key, value);
+	} else if (key == "accept-batch") {
+		acceptBatch = parseNumber(key, value);
+	} else if (key == "max-clients") {
+		maxClients = parseNumber(key, value);
+	} else if (key == "cpu") {
+		cpu = static_cast<int>(parseNumber(key, value, 0));
+	} else {
+		throw std::runtime_error("Unknown option: " + key);
+	}
+}
+
+void Config::applyCpuAffinity() const {
+	if (cpu < 0) {
+		return;
+	}
+#ifdef __linux__
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+		throw std::runtime_error(
+			"Affinity error: [" + std::string(strerror(errno)) + "]");
+	}
+#else
+	throw std::runtime_error("CPU pinning is not supported on this platform");
+#endif
+}
@@ -0,0 +1,106 @@
+#include "../headers/EpollLoop.hpp"
+
+#ifdef __linux__
+
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <unistd.h>
+
+EpollLoop::EpollLoop(bool edgeTriggered) : _edgeTriggered(edgeTriggered) {
+	_epollFd = epoll_create1(EPOLL_CLOEXEC);
+	if (_epollFd == -1) {
+		throw std::runtime_error(
+			"Epoll error: [" + std::string(strerror(errno)) + "]");
+	}
+}
+
+EpollLoop::~EpollLoop() {
+	close(_epollFd);
+}
+
+const char *EpollLoop::name() const {
+	return _edgeTriggered ? "epoll-et" : "epoll";
+}
+
+bool EpollLoop::edgeTriggered() const {
+	return _edgeTriggered;
+}
+
+void EpollLoop::control(int op, int fd, unsigned int events) {
+	epoll_event event;
+	event.events = EPOLLRDHUP;
+	if (events & (EV_READ | EV_ACCEPT)) {
+		event.events |= EPOLLIN;
+	}
+	// in edge-triggered mode write interest stays registered: an edge is only
+	// reported when the send buffer goes from full to writable
+	if ((events & EV_WRITE) || _edgeTriggered) {
+		event.events |= EPOLLOUT;
+	}
+	if (_edgeTriggered) {
+		event.events |= EPOLLET;
+	}
+	if (fd >= static_cast<int>(_interest.size())) {
+		_interest.resize(fd + 1, 0);
+	}
+	if (op == EPOLL_CTL_MOD && _interest[fd] == event.events) {
+		return;
+	}
+	event.data.fd = fd;
+	if (epoll_ctl(_epollFd, op, fd, &event) == -1) {
+		throw std::runtime_error(
+			"Epoll_ctl error: [" + std::string(strerror(errno)) + "]");
+	}
+	_interest[fd] = event.events;
+}
+
+void EpollLoop::add(int fd, unsigned int events) {
+	control(EPOLL_CTL_ADD, fd, events);
+}
+
+void EpollLoop::modify(int fd, unsigned int events) {
+	if (fd >= static_cast<int>(_interest.size()) || !_interest[fd]) {
+		return;
+	}
+	control(EPOLL_CTL_MOD, fd, events);
+}
+
+void EpollLoop::remove(int fd) {
+	if (fd >= static_cast<int>(_interest.size()) || !_interest[fd]) {
+		return;
+	}
+	epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, NULL);
+	_interest[fd] = 0;
+}
+
+void EpollLoop::wait(std::vector<IoReady> &ready, int timeoutMs) {
+	ready.clear();
+	int countEvents = epoll_wait(_epollFd, _events, MAX_READY_EVENTS, timeoutMs);
+	if (countEvents < 0) {
+		if (errno == EINTR) {
+			return;
+		}
+		throw std::runtime_error(
+			"Epoll_wait error: [" + std::string(strerror(errno)) + "]");
+	}
+	for (int i = 0; i < countEvents; i++) {
+		IoReady event;
+		event.fd = _events[i].data.fd;
+		event.events = 0;
+		event.data = NULL;
+		event.length = 0;
+		if (_events[i].events & EPOLLIN) {
+			event.events |= EV_READ;
+		}
+		if (_events[i].events & EPOLLOUT) {
+			event.events |= EV_WRITE;
+		}
+		if (_events[i].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) {
+			event.events |= EV_CLOSE;
+		}
+		ready.push_back(event);
+	}
+}
+
+#endif
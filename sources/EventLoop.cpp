@@ -0,0 +1,72 @@
+#include "../headers/EventLoop.hpp"
+#include "../headers/PollLoop.hpp"
+#include "../headers/EpollLoop.hpp"
+#include "../headers/UringLoop.hpp"
+#include <iostream>
+#include <unistd.h>
+
+EventLoop *EventLoop::create(Backend backend) {
+	switch (backend) {
+#ifdef __linux__
+		case EPOLL:
+			return new EpollLoop(false);
+		case EPOLL_ET:
+			return new EpollLoop(true);
+		case IO_URING:
+			try {
+				return new UringLoop();
+			} catch (std::exception &e) {
+				std::cerr << "[WARN] " << e.what() << ", falling back to epoll" << std::endl;
+				return new EpollLoop(false);
+			}
+#endif
+		default:
+			return new PollLoop();
+	}
+}
+
+bool EventLoop::parseBackend(const std::string &name, Backend &backend) {
+	if (name == "poll") {
+		backend = POLL;
+#ifdef __linux__
+	} else if (name == "epoll") {
+		backend = EPOLL;
+	} else if (name == "epoll-et") {
+		backend = EPOLL_ET;
+	} else if (name == "io_uring") {
+		backend = IO_URING;
+#endif
+	} else {
+		return false;
+	}
+	return true;
+}
+
+EventLoop::Backend EventLoop::defaultBackend() {
+#ifdef __linux__
+	return EPOLL;
+#else
+	return POLL;
+#endif
+}
+
+bool EventLoop::completionBased() const {
+	return false;
+}
+
+void EventLoop::closeDescriptor(int fd) {
+	remove(fd);
+	close(fd);
+}
+
+size_t EventLoop::pendingOutput(int fd) const {
+	(void) fd;
+	return 0;
+}
+
+void EventLoop::send(int fd, const char *data, size_t length) {
+	// readiness backends leave the writes to the caller
+	(void) fd;
+	(void) data;
+	(void) length;
+}
@@ -0,0 +1,82 @@
+#include "../headers/Mask.hpp"
+#include <cctype>
+
+// greedy scan that only backtracks to the last '*', linear unless the mask
+// holds several stars
+bool matchMask(const std::string &mask, const std::string &text) {
+	size_t m = 0;
+	size_t t = 0;
+	size_t star = std::string::npos;
+	size_t resume = 0;
+
+	while (t < text.size()) {
+		if (m < mask.size() && mask[m] == '*') {
+			star = m++;
+			resume = t;
+		} else if (m < mask.size() && (mask[m] == '?'
+				   || tolower(static_cast<unsigned char>(mask[m])) == tolower(static_cast<unsigned char>(text[t])))) {
+			m++;
+			t++;
+		} else if (star != std::string::npos) {
+			m = star + 1;
+			t = ++resume;
+		} else {
+			return false;
+		}
+	}
+	while (m < mask.size() && mask[m] == '*') {
+		m++;
+	}
+	return m == mask.size();
+}
+
+static std::string fold(const std::string &text) {
+	std::string folded(text);
+	for (size_t i = 0; i < folded.size(); i++) {
+		folded[i] = tolower(static_cast<unsigned char>(folded[i]));
+	}
+	return folded;
+}
+
+Mask::Mask()
+	: _wildcards(false),
+	  _all(false) {
+}
+
+Mask::Mask(const std::string &pattern)
+	: _pattern(fold(pattern)) {
+	size_t wildcard = _pattern.find_first_of("*?");
+	_wildcards = wildcard != std::string::npos;
+	_prefix = _pattern.substr(0, wildcard);
+	_all = !_pattern.empty() && _pattern.find_first_not_of('*') == std::string::npos;
+}
+
+bool Mask::match(const std::string &text) const {
+	if (_all) {
+		return true;
+	}
+	if (text.size() < _prefix.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < _prefix.size(); i++) {
+		if (tolower(static_cast<unsigned char>(text[i])) != _prefix[i]) {
+			return false;
+		}
+	}
+	if (!_wildcards) {
+		return text.size() == _prefix.size();
+	}
+	return matchMask(_pattern, text);
+}
+
+bool Mask::matchesAll() const {
+	return _all;
+}
+
+bool Mask::exact() const {
+	return !_wildcards;
+}
+
+const std::string &Mask::prefix() const {
+	return _prefix;
+}
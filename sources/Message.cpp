@@ -0,0 +1,87 @@
+#include <cstring>
+#include "../headers/Message.hpp"
+
+Slice::Slice() : data(NULL), length(0) {
+}
+
+Slice::Slice(const char *data, size_t length) : data(data), length(length) {
+}
+
+bool Slice::empty() const {
+	return length == 0;
+}
+
+char Slice::first() const {
+	return length ? data[0] : '\0';
+}
+
+std::string Slice::str() const {
+	return std::string(data ? data : "", length);
+}
+
+bool Slice::operator==(const char *other) const {
+	return strlen(other) == length && memcmp(data, other, length) == 0;
+}
+
+bool Slice::operator!=(const char *other) const {
+	return !(*this == other);
+}
+
+Message::Message() : paramCount(0), trailing(false) {
+}
+
+// next space separated word starting at pos, pos is left on the following space
+static Slice word(const char *line, size_t length, size_t &pos) {
+	size_t start = pos;
+	while (pos < length && line[pos] != ' ') {
+		pos++;
+	}
+	return Slice(line + start, pos - start);
+}
+
+static void skipSpaces(const char *line, size_t length, size_t &pos) {
+	while (pos < length && line[pos] == ' ') {
+		pos++;
+	}
+}
+
+bool Message::parse(const char *line, size_t length) {
+	size_t pos = 0;
+	tags = Slice();
+	prefix = Slice();
+	command = Slice();
+	paramCount = 0;
+	trailing = false;
+
+	skipSpaces(line, length, pos);
+	if (pos < length && line[pos] == '@') {
+		pos++;
+		tags = word(line, length, pos);
+		skipSpaces(line, length, pos);
+	}
+	if (pos < length && line[pos] == ':') {
+		pos++;
+		prefix = word(line, length, pos);
+		skipSpaces(line, length, pos);
+	}
+	command = word(line, length, pos);
+	if (command.empty()) {
+		return false;
+	}
+	while (true) {
+		skipSpaces(line, length, pos);
+		if (pos >= length) {
+			break;
+		}
+		if (line[pos] == ':' || paramCount == MESSAGE_MAX_PARAMS - 1) {
+			if (line[pos] == ':') {
+				pos++;
+				trailing = true;
+			}
+			params[paramCount++] = Slice(line + pos, length - pos);
+			break;
+		}
+		params[paramCount++] = word(line, length, pos);
+	}
+	return true;
+}
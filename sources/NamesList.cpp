@@ -0,0 +1,65 @@
+#include "../headers/NamesList.hpp"
+
+NamesList::NamesList(size_t limit)
+	: _limit(limit),
+	  _bytes(0) {
+}
+
+size_t NamesList::insert(const std::string &entry) {
+	if (_chunks.empty() || (!_chunks.back().empty() && _chunks.back().size() + 1 + entry.size() > _limit)) {
+		_chunks.push_back(std::string());
+		_chunks.back().reserve(_limit);
+	}
+	std::string &chunk = _chunks.back();
+	if (!chunk.empty()) {
+		chunk += ' ';
+		_bytes++;
+	}
+	chunk += entry;
+	_bytes += entry.size();
+	return _chunks.size() - 1;
+}
+
+void NamesList::erase(size_t chunk, const std::string &entry) {
+	if (chunk >= _chunks.size()) {
+		return;
+	}
+	std::string &text = _chunks[chunk];
+	size_t at = 0;
+	// the entry has to match a whole space separated token
+	while ((at = text.find(entry, at)) != std::string::npos) {
+		size_t end = at + entry.size();
+		if ((at == 0 || text[at - 1] == ' ') && (end == text.size() || text[end] == ' ')) {
+			break;
+		}
+		at = end;
+	}
+	if (at == std::string::npos) {
+		return;
+	}
+	size_t end = at + entry.size();
+	if (end < text.size()) {
+		end++;
+	} else if (at > 0) {
+		at--;
+	}
+	_bytes -= end - at;
+	text.erase(at, end - at);
+	while (!_chunks.empty() && _chunks.back().empty()) {
+		_chunks.pop_back();
+	}
+}
+
+void NamesList::clear() {
+	_chunks.clear();
+	_bytes = 0;
+}
+
+// erasing leaves holes behind, past twice the chunks needed the owner rebuilds
+bool NamesList::fragmented() const {
+	return _chunks.size() > 2 * (_bytes / _limit) + 2;
+}
+
+const std::vector<std::string> &NamesList::chunks() const {
+	return _chunks;
+}
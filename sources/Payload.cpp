@@ -0,0 +1,83 @@
+#include <new>
+#include <cstring>
+#include "../headers/Payload.hpp"
+
+Payload::Payload(size_t length) : _refs(1), _length(length) {
+}
+
+Payload::~Payload() {
+}
+
+Payload *Payload::create(size_t length) {
+	void *block = ::operator new(sizeof(Payload) + length);
+	return new (block) Payload(length);
+}
+
+Payload *Payload::create(const std::string &message) {
+	Payload *payload = create(message.size());
+	memcpy(payload->data(), message.data(), message.size());
+	return payload;
+}
+
+void Payload::retain() {
+	_refs++;
+}
+
+void Payload::release() {
+	if (--_refs == 0) {
+		this->~Payload();
+		::operator delete(this);
+	}
+}
+
+char *Payload::data() {
+	return reinterpret_cast<char *>(this + 1);
+}
+
+const char *Payload::data() const {
+	return reinterpret_cast<const char *>(this + 1);
+}
+
+size_t Payload::length() const {
+	return _length;
+}
+
+PayloadRef::PayloadRef() : _payload(NULL) {
+}
+
+PayloadRef::PayloadRef(Payload *payload) : _payload(payload) {
+}
+
+PayloadRef::PayloadRef(const std::string &message) : _payload(Payload::create(message)) {
+}
+
+PayloadRef::PayloadRef(const PayloadRef &other) : _payload(other._payload) {
+	if (_payload) {
+		_payload->retain();
+	}
+}
+
+PayloadRef &PayloadRef::operator=(const PayloadRef &other) {
+	if (other._payload) {
+		other._payload->retain();
+	}
+	if (_payload) {
+		_payload->release();
+	}
+	_payload = other._payload;
+	return *this;
+}
+
+PayloadRef::~PayloadRef() {
+	if (_payload) {
+		_payload->release();
+	}
+}
+
+const char *PayloadRef::data() const {
+	return _payload ? _payload->data() : NULL;
+}
+
+size_t PayloadRef::length() const {
+	return _payload ? _payload->length() : 0;
+}
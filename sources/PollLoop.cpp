@@ -0,0 +1,98 @@
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include "../headers/PollLoop.hpp"
+
+PollLoop::PollLoop() {
+}
+
+PollLoop::~PollLoop() {
+}
+
+const char *PollLoop::name() const {
+	return "poll";
+}
+
+bool PollLoop::edgeTriggered() const {
+	return false;
+}
+
+pollfd *PollLoop::find(int fd) {
+	if (fd < 0 || fd >= static_cast<int>(_slots.size()) || _slots[fd] == -1) {
+		return NULL;
+	}
+	return &_pollFds[_slots[fd]];
+}
+
+void PollLoop::add(int fd, unsigned int events) {
+	pollfd pollFd;
+	pollFd.fd = fd;
+	pollFd.events = 0;
+	pollFd.revents = 0;
+	if (fd >= static_cast<int>(_slots.size())) {
+		_slots.resize(fd + 1, -1);
+	}
+	_slots[fd] = _pollFds.size();
+	_pollFds.push_back(pollFd);
+	modify(fd, events);
+}
+
+void PollLoop::modify(int fd, unsigned int events) {
+	pollfd *pollFd = find(fd);
+	if (!pollFd) {
+		return;
+	}
+	pollFd->events = 0;
+	if (events & (EV_READ | EV_ACCEPT)) {
+		pollFd->events |= POLLIN;
+	}
+	if (events & EV_WRITE) {
+		pollFd->events |= POLLOUT;
+	}
+}
+
+void PollLoop::remove(int fd) {
+	if (!find(fd)) {
+		return;
+	}
+	// the last entry takes the freed slot
+	int slot = _slots[fd];
+	_pollFds[slot] = _pollFds.back();
+	_slots[_pollFds[slot].fd] = slot;
+	_pollFds.pop_back();
+	_slots[fd] = -1;
+}
+
+void PollLoop::wait(std::vector<IoReady> &ready, int timeoutMs) {
+	ready.clear();
+	int countEvents = poll(&_pollFds[0], _pollFds.size(), timeoutMs);
+	if (countEvents < 0) {
+		if (errno == EINTR) {
+			return;
+		}
+		throw std::runtime_error(
+			"Poll error: [" + std::string(strerror(errno)) + "]");
+	}
+	for (size_t i = 0; i < _pollFds.size() && countEvents > 0; i++) {
+		if (!_pollFds[i].revents) {
+			continue;
+		}
+		IoReady event;
+		event.fd = _pollFds[i].fd;
+		event.events = 0;
+		event.data = NULL;
+		event.length = 0;
+		if (_pollFds[i].revents & POLLIN) {
+			event.events |= EV_READ;
+		}
+		if (_pollFds[i].revents & POLLOUT) {
+			event.events |= EV_WRITE;
+		}
+		if (_pollFds[i].revents & (POLLHUP | POLLERR | POLLNVAL)) {
+			event.events |= EV_CLOSE;
+		}
+		_pollFds[i].revents = 0;
+		ready.push_back(event);
+		countEvents--;
+	}
+}
@@ -1,64 +1,73 @@
 #include "../headers/Server.hpp"
 
-Server::Server(int port, const std::string &password) {
+Server::Server(int port, const std::string &password, const Config &config)
+	: clients(config.maxClients),
+	  _epoch(0) {
 	// setting the address family - AF_INET for IPv4
 	address.sin_family = AF_INET;
 	// setting the port converting port value to network byte order
 	address.sin_port = htons(port);
 	// setting the IP - INADDR_ANY for any network interface on the machine - converting it to network byte order.
 	address.sin_addr.s_addr = htonl(INADDR_ANY);
-	// creating the main listening socket and adding it to pollFds container
+	// creating the main listening socket and registering it in the event loop
 	socketFd = socket(address.sin_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
 	if (socketFd == -1) {
 		throw std::runtime_error(
 			"Socket error: [" + std::string(strerror(errno)) + "]");
 	}
-	pollfd serverPollFd;
-	serverPollFd.fd = socketFd;
-	serverPollFd.events = POLLIN;
-	serverPollFd.revents = 0;
-	pollFds.push_back(serverPollFd);
+	_loop = EventLoop::create(config.backend);
+	_loop->add(socketFd, EV_ACCEPT);
 	// binding socket to the port
 	if (bind(this->socketFd, (sockaddr *) (&address), sizeof(address)) == -1) {
 		throw std::runtime_error(
 			"Bind error: [" + std::string(strerror(errno)) + "]");
 	}
 	this->start = time(0);
+	this->_now = TimerWheel::now();
+	this->_config = config;
+	_ready.reserve(MAX_READY_EVENTS);
+	_writers.reserve(_config.acceptBatch);
 	this->_password = password;
 	this->serverName = "42.IRC";
 	this->serverVersion = "1.0";
-	initCmd();
 	initChannelMode();
-	initServerMessages();
+	initReplies();
 	listenPort();
-	memset(_buffer, 0, 1024);
 	std::cout << "Server created: address=" << inet_ntoa(address.sin_addr)
 			  << ":"
 			  << ntohs(address.sin_port)
 			  << " socketFD=" << socketFd
+			  << " backend=" << _loop->name()
 			  << " _password=" << this->_password << std::endl;
 }
 
-void Server::initCmd() {
-	cmd["PRIVMSG"] = &Server::processPrivmsg;
-	cmd["NOTICE"] = &Server::processPrivmsg;
-	cmd["JOIN"] = &Server::processJoin;
-	cmd["INVITE"] = &Server::processInvite;
-	cmd["KICK"] = &Server::processKick;
-	cmd["TOPIC"] = &Server::processTopic;
-	cmd["PART"] = &Server::processPart;
-	cmd["MODE"] = &Server::processMode;
-	cmd["NAMES"] = &Server::processNames;
-	cmd["LIST"] = &Server::processList;
-	cmd["PING"] = &Server::processPing;
-	cmd["AWAY"] = &Server::processAway;
-	cmd["NICK"] = &Server::processNick;
-	cmd["QUIT"] = &Server::processQuit;
-    cmd["WHO"] = &Server::processWho;
-    cmd["WHOIS"] = &Server::processWhois;
-}
+const Server::Command Server::commands[CMD_COUNT] = {
+	{"PASS", &Server::processPass, CMD_UNREGISTERED},
+	{"NICK", &Server::processNick, CMD_UNREGISTERED | CMD_REGISTERED},
+	{"USER", &Server::processUser, CMD_UNREGISTERED},
+	{"CAP", &Server::processCap, CMD_UNREGISTERED | CMD_REGISTERED},
+	{"PING", &Server::processPing, CMD_REGISTERED},
+	{"PONG", &Server::processPong, CMD_REGISTERED},
+	{"QUIT", &Server::processQuit, CMD_REGISTERED},
+	{"PRIVMSG", &Server::processPrivmsg, CMD_REGISTERED},
+	{"NOTICE", &Server::processPrivmsg, CMD_REGISTERED},
+	{"JOIN", &Server::processJoin, CMD_REGISTERED},
+	{"INVITE", &Server::processInvite, CMD_REGISTERED},
+	{"KICK", &Server::processKick, CMD_REGISTERED},
+	{"TOPIC", &Server::processTopic, CMD_REGISTERED},
+	{"PART", &Server::processPart, CMD_REGISTERED},
+	{"MODE", &Server::processMode, CMD_REGISTERED},
+	{"NAMES", &Server::processNames, CMD_REGISTERED},
+	{"LIST", &Server::processList, CMD_REGISTERED},
+	{"AWAY", &Server::processAway, CMD_REGISTERED},
+	{"WHO", &Server::processWho, CMD_REGISTERED},
+	{"WHOIS", &Server::processWhois, CMD_REGISTERED}
+};
 
 void Server::initChannelMode() {
+	for (int i = 0; i < 256; i++) {
+		channelMode[i] = NULL;
+	}
 	channelMode['i'] = &Server::handleModeI;
 	channelMode['t'] = &Server::handleModeT;
 	channelMode['k'] = &Server::handleModeK;
@@ -67,186 +76,371 @@ void Server::initChannelMode() {
     channelMode['b'] = &Server::handleModeB;
 }
 
-void Server::initServerMessages() {
-	_serverMessages[RPL_WELCOME] = " Welcome to the IRC Network";
-	_serverMessages[RPL_YOURHOST] = " :Your host is " + serverName + " version " + serverVersion;
-	_serverMessages[RPL_CREATED] = " :This server was created " + static_cast<std::string>(ctime(&start));
-	_serverMessages[RPL_MYINFO] = " " + serverName + " " + serverVersion + " available user/channel modes: +is/+itkl";
-
-	_serverMessages[RPL_LISTEND] = " :End of /LIST";
-	_serverMessages[RPL_NOTOPIC] = " :No topic is set";
-	_serverMessages[RPL_ENDOFNAMES] = " :End of /NAMES list";
-	_serverMessages[RPL_UNAWAY] = " :You are no longer marked as being away";
-	_serverMessages[RPL_NOWAWAY] = " :You have been marked as being away";
-    _serverMessages[RPL_ENDOFWHO] = " :End of WHO list";
-    _serverMessages[RPL_ENDOFWHOIS] = " :End of WHOIS list";
-
-	_serverMessages[ERR_NOSUCHNICK] = " :No such nick/channel";
-	_serverMessages[ERR_NOSUCHSERVER] = " :No such server";
-	_serverMessages[ERR_NOSUCHCHANNEL] = " :No such channel";
-	_serverMessages[ERR_CANNOTSENDTOCHAN] = " :Cannot send to channel";
-	_serverMessages[ERR_TOOMANYCHANNELS] = " :You have joined too many channels";
-	_serverMessages[ERR_TOOMANYTARGETS] = " :Too many targets";
-	_serverMessages[ERR_NOORIGIN] = " :No origin specified";
-	_serverMessages[ERR_NORECIPIENT] = " :No recipient given";
-	_serverMessages[ERR_NOTEXTTOSEND] = " :No text to send";
-	_serverMessages[ERR_UNKNOWNCOMMAND] = " :Unknown command";
-	_serverMessages[ERR_ERRONEUSNICKNAME] = " :Erroneus nickname";
-	_serverMessages[ERR_NICKNAMEINUSE] = " :Nickname is already in use";
-	_serverMessages[ERR_USERNOTINCHANNEL] = " :They aren't on that channel";
-	_serverMessages[ERR_NOTONCHANNEL] = " :You're not on that channel";
-	_serverMessages[ERR_USERONCHANNEL] = " :is already on channel";
-	_serverMessages[ERR_NEEDMOREPARAMS] = " :Not enough parameters";
-	_serverMessages[ERR_ALREADYREGISTERED] = " :You may not reregister";
-	_serverMessages[ERR_PASSWDMISMATCH] = " :Password incorrect";
-	_serverMessages[ERR_CHANNELISFULL] = " :Cannot join channel (+l)";
-	_serverMessages[ERR_UNKNOWNMODE] = " :is unknown mode char to me";
-	_serverMessages[ERR_INVITEONLYCHAN] = " :Cannot join channel (+i)";
-	_serverMessages[ERR_BADCHANNELKEY] = " :Cannot join channel (+k)";
-	_serverMessages[ERR_CHANOPRIVSNEEDED] = " :You're not channel operator";
-	_serverMessages[ERR_UMODEUNKNOWNFLAG] = " :Unknown MODE flag";
-	_serverMessages[ERR_USERSDONTMATCH] = " :Cant change mode for other users";
-	_serverMessages[ERR_NONICKNAMEGIVEN] = " :No nickname given";
-    _serverMessages[RPL_ENDOFBANLIST] = " :End of channel ban list";
+void Server::initReplies() {
+	_replies.resize(REPLY_TABLE_SIZE);
+	_replies[RPL_WELCOME].text = " Welcome to the IRC Network";
+	_replies[RPL_YOURHOST].text = " :Your host is " + serverName + " version " + serverVersion;
+	std::string created = ctime(&start);
+	_replies[RPL_CREATED].text = " :This server was created " + created.substr(0, created.find('\n'));
+	_replies[RPL_MYINFO].text = " " + serverName + " " + serverVersion + " available user/channel modes: +is/+itkl";
+
+	_replies[RPL_LISTEND].text = " :End of /LIST";
+	_replies[RPL_NOTOPIC].text = " :No topic is set";
+	_replies[RPL_ENDOFNAMES].text = " :End of /NAMES list";
+	_replies[RPL_UNAWAY].text = " :You are no longer marked as being away";
+	_replies[RPL_NOWAWAY].text = " :You have been marked as being away";
+    _replies[RPL_ENDOFWHO].text = " :End of WHO list";
+    _replies[RPL_ENDOFWHOIS].text = " :End of WHOIS list";
+	_replies[RPL_WHOISSERVER].text = " :" + serverName + " " + serverVersion;
+
+	_replies[ERR_NOSUCHNICK].text = " :No such nick/channel";
+	_replies[ERR_NOSUCHSERVER].text = " :No such server";
+	_replies[ERR_NOSUCHCHANNEL].text = " :No such channel";
+	_replies[ERR_CANNOTSENDTOCHAN].text = " :Cannot send to channel";
+	_replies[ERR_TOOMANYCHANNELS].text = " :You have joined too many channels";
+	_replies[ERR_TOOMANYTARGETS].text = " :Too many targets";
+	_replies[ERR_NOORIGIN].text = " :No origin specified";
+	_replies[ERR_NORECIPIENT].text = " :No recipient given";
+	_replies[ERR_NOTEXTTOSEND].text = " :No text to send";
+	_replies[ERR_UNKNOWNCOMMAND].text = " :Unknown command";
+	_replies[ERR_ERRONEUSNICKNAME].text = " :Erroneus nickname";
+	_replies[ERR_NICKNAMEINUSE].text = " :Nickname is already in use";
+	_replies[ERR_USERNOTINCHANNEL].text = " :They aren't on that channel";
+	_replies[ERR_NOTONCHANNEL].text = " :You're not on that channel";
+	_replies[ERR_USERONCHANNEL].text = " :is already on channel";
+	_replies[ERR_NEEDMOREPARAMS].text = " :Not enough parameters";
+	_replies[ERR_ALREADYREGISTERED].text = " :You may not reregister";
+	_replies[ERR_PASSWDMISMATCH].text = " :Password incorrect";
+	_replies[ERR_CHANNELISFULL].text = " :Cannot join channel (+l)";
+	_replies[ERR_UNKNOWNMODE].text = " :is unknown mode char to me";
+	_replies[ERR_INVITEONLYCHAN].text = " :Cannot join channel (+i)";
+	_replies[ERR_BADCHANNELKEY].text = " :Cannot join channel (+k)";
+	_replies[ERR_CHANOPRIVSNEEDED].text = " :You're not channel operator";
+	_replies[ERR_UMODEUNKNOWNFLAG].text = " :Unknown MODE flag";
+	_replies[ERR_USERSDONTMATCH].text = " :Cant change mode for other users";
+	_replies[ERR_NONICKNAMEGIVEN].text = " :No nickname given";
+    _replies[RPL_ENDOFBANLIST].text = " :End of channel ban list";
 
+	// every numeric starts with the same server prefix and zero padded code
+	for (int id = 0; id < REPLY_TABLE_SIZE; id++) {
+		char code[4] = {static_cast<char>('0' + id / 100), static_cast<char>('0' + id / 10 % 10),
+						static_cast<char>('0' + id % 10), '\0'};
+		_replies[id].head = ":" + serverName + " " + code + " ";
+	}
+	_capLs = PayloadRef("CAP * LS :\r\n");
 }
 
 Server::~Server() {
-	// Memory Cleanup
-	for (std::map<int, Client *>::iterator it = clients.begin();
-		 it != clients.end(); ++it) {
-		delete it->second;
-	}
-	for (std::vector<Channel *>::iterator it = _channels.begin();
+	// Memory Cleanup, clients are destroyed with their table
+	for (ChannelMap::iterator it = _channels.begin();
 		 it != _channels.end(); ++it) {
-		delete *it;
+		delete it->second;
 	}
 	// Closing sockets
-	for (std::vector<pollfd>::iterator it = pollFds.begin();
-		 it != pollFds.end(); ++it) {
-		close(it->fd);
+	for (std::vector<int>::const_iterator it = clients.fds().begin();
+		 it != clients.fds().end(); ++it) {
+		close(*it);
 	}
+	close(socketFd);
+	delete _loop;
 }
 
 void Server::addClient(int clientSocket, std::string clientHostname) {
-	// Create a new Client object and insert it into the clients map
-	clients.insert(std::make_pair(clientSocket, new Client(clientSocket, clientHostname)));
+	// Construct the Client in its table slot
+	Client *client = clients.create(clientSocket, clientHostname);
+	if (!client) {
+		std::cout << "[ERR] Too many clients, closing fd " << clientSocket << std::endl;
+		_loop->closeDescriptor(clientSocket);
+		return;
+	}
+	_loop->add(clientSocket, EV_READ);
+	client->setLastActivity(_now);
+	startTimer(client, TIMER_REGISTRATION, _config.registrationTimeout * 1000);
 }
 
 void Server::removeClient(int clientSocket) {
-	// removing from _channels
-	for (std::vector<Channel *>::iterator it = _channels.begin(); it != _channels.end();) {
-		(*it)->removeMember(clientSocket);
-		if ((*it)->getMemberFds().empty()) {
-			delete *it;
-			it = _channels.erase(it);
-		} else {
-			++it;
-		}
+	Client *client = clients[clientSocket];
+	if (!client) {
+		return;
 	}
-	// removing from pollFds
-	for (std::vector<pollfd>::iterator it = pollFds.begin(); it != pollFds.end(); ++it) {
-		if (it->fd == clientSocket) {
-			pollFds.erase(it);
-			break;
-		}
+	// only the client's own channels and invites reference it
+	while (!client->getChannels().empty()) {
+		removeClientFromChannel(clientSocket, client->getChannels().back());
 	}
-	// removing from users, deleting and removing from clients
-	std::map<int, Client *>::iterator it = clients.find(clientSocket);
-	if (it != clients.end()) {
-		users.erase(it->second->getNickname());
-		delete it->second;
-		clients.erase(it);
+	while (!client->getInvites().empty()) {
+		Channel *channel = client->getInvites().back();
+		channel->removeInvited(clientSocket);
+		client->removeInvite(channel);
+	}
+	// releasing the nickname and the table slot
+	std::map<std::string, Client *>::iterator nick = _nicknames.find(client->getNickname());
+	if (nick != _nicknames.end() && nick->second == client) {
+		_nicknames.erase(nick);
+		indexHost(client, false);
+	}
+	_timers.cancel(client->getTimer());
+	clients.destroy(clientSocket);
+	// unregistering from the event loop and closing the socket
+	_loop->closeDescriptor(clientSocket);
+}
+
+void Server::disconnectClient(int fd, const std::string &reason) {
+	Client *client = findClient(fd);
+	if (!client) {
+		return;
+	}
+	notifyQuit(fd, reason);
+	serverSendError(fd, reason, ERROR);
+	client->setQuit(true);
+	// a single best effort flush, the peer is most likely gone
+	sendData(fd);
+	if (findClient(fd)) {
+		removeClient(fd);
+	}
+}
+
+void Server::startTimer(Client *client, TimerKind kind, unsigned long delayMs) {
+	Timer &timer = client->getTimer();
+	timer.kind = kind;
+	_timers.schedule(timer, delayMs);
+}
+
+void Server::expireTimers() {
+	_timers.advance(_now, _expired);
+	for (std::vector<Timer *>::iterator it = _expired.begin(); it != _expired.end(); ++it) {
+		handleTimer(*it);
+	}
+}
+
+void Server::handleTimer(Timer *timer) {
+	Client *client = findClient(timer->fd);
+	if (!client) {
+		return;
+	}
+	unsigned long idle = _now - client->getLastActivity();
+	unsigned long pingInterval = _config.pingInterval * 1000;
+	switch (timer->kind) {
+		case TIMER_REGISTRATION:
+			if (!client->isRegistered()) {
+				disconnectClient(timer->fd, "Registration timeout");
+			}
+			break;
+		case TIMER_IDLE:
+			if (idle < pingInterval) {
+				// traffic was seen since the timer was armed
+				startTimer(client, TIMER_IDLE, pingInterval - idle);
+			} else {
+				serverSendMessage(timer->fd, "PING :" + serverName + "\r\n");
+				client->setPingSent(_now);
+				startTimer(client, TIMER_PONG, _config.pingTimeout * 1000);
+			}
+			break;
+		case TIMER_PONG:
+			// input read in the PING's own millisecond still counts as an answer
+			if (client->getLastActivity() >= client->getPingSent()) {
+				startTimer(client, TIMER_IDLE, idle < pingInterval ? pingInterval - idle : pingInterval);
+			} else {
+				disconnectClient(timer->fd, "Ping timeout");
+			}
+			break;
 	}
 }
 
 void Server::run() {
-	for (std::map<int, Client *>::iterator it = clients.begin();
-		 it != clients.end(); ++it) {
-		if (!it->second->sendQueueEmpty()) {
-			for (std::vector<pollfd>::iterator it2 = pollFds.begin();
-				 it2 != pollFds.end(); ++it2) {
-				if (it2->fd == it->first) {
-					it2->events = POLLOUT;
-					break;
+	// sleeps until a socket is ready or the next timer is due
+	// paused LIST replies whose client caught up are resumed without sleeping
+	_loop->wait(_ready, pagersReady() ? 0 : _timers.nextTimeout(TimerWheel::now()));
+	_now = TimerWheel::now();
+	for (std::vector<IoReady>::iterator it = _ready.begin(); it != _ready.end(); ++it) {
+		if (it->fd == socketFd) {
+			acceptConnections();
+			continue;
+		}
+		if (it->events & EV_ACCEPT) {
+			addClient(it->fd, peerHostname(it->fd));
+			continue;
+		}
+		if (it->data) {
+			Client *client = findClient(it->fd);
+			if (client && !client->isQuit()) {
+				client->appendRecvBuffer(it->data, it->length);
+				if (processInput(client)) {
+					client->releaseRecvBuffer();
 				}
 			}
+		} else if (_loop->completionBased() && (it->events & EV_CLOSE)) {
+			if (findClient(it->fd)) {
+				processQuit(it->fd, Message());
+				removeClient(it->fd);
+			}
+		} else if (it->events & (EV_READ | EV_CLOSE)) {
+			receiveData(it->fd);
+		}
+		if ((it->events & EV_WRITE) && findClient(it->fd)) {
+			sendData(it->fd);
 		}
 	}
-	int countEvents = poll(&pollFds[0], pollFds.size(), 0);
-	if (countEvents < 0) {
-		throw std::runtime_error(
-			"Poll error: [" + std::string(strerror(errno)) + "]");
+	resumePagers();
+	expireTimers();
+	flushWriters();
+}
+
+// write-through at the end of the command batch: replies usually fit in the
+// socket buffer right away, write interest is only armed for what remains
+void Server::flushWriters() {
+	for (size_t i = 0; i < _writers.size(); i++) {
+		int fd = _writers[i];
+		Client *client = findClient(fd);
+		if (!client || !client->isPendingWrite()) {
+			continue;
+		}
+		client->setPendingWrite(false);
+		sendData(fd);
+		client = findClient(fd);
+		if (client && !client->sendQueueEmpty()
+			&& !_loop->edgeTriggered() && !_loop->completionBased()) {
+			_loop->modify(fd, EV_READ | EV_WRITE);
+		}
 	}
-	for (size_t i = 0; i < pollFds.size(); i++) {
-		if (pollFds[i].revents & POLLIN) {
-			i = receiveData(i);
+	_writers.clear();
+}
+
+bool Server::outputDrained(Client *client) {
+	return client->sendQueueEmpty() && !_loop->pendingOutput(client->getSocket());
+}
+
+// resumes paused LIST and WHO replies whose client caught up with its output
+void Server::resumePagers() {
+	for (size_t i = 0; i < _listings.size();) {
+		Client *client = clients.find(_listings[i].client);
+		if (!client || client->isQuit()
+			|| (outputDrained(client) && !listNextPage(_listings[i]))) {
+			_listings.erase(_listings.begin() + i);
+		} else {
+			i++;
+		}
+	}
+	for (size_t i = 0; i < _whoPagers.size();) {
+		Client *client = clients.find(_whoPagers[i].client);
+		if (!client || client->isQuit()
+			|| (outputDrained(client) && !whoNextPage(_whoPagers[i]))) {
+			_whoPagers.erase(_whoPagers.begin() + i);
+		} else {
+			i++;
+		}
+	}
+}
+
+bool Server::pagersReady() {
+	for (size_t i = 0; i < _listings.size(); i++) {
+		Client *client = clients.find(_listings[i].client);
+		if (!client || outputDrained(client)) {
+			return true;
 		}
-		if (pollFds[i].revents & POLLOUT) {
-			sendData(i);
+	}
+	for (size_t i = 0; i < _whoPagers.size(); i++) {
+		Client *client = clients.find(_whoPagers[i].client);
+		if (!client || outputDrained(client)) {
+			return true;
 		}
 	}
+	return false;
 }
 
-size_t Server::receiveData(size_t index) {
-// if index == 0 -> first connection
-	if (index == 0) {
+void Server::acceptConnections() {
+	// the backlog is drained in batches, an edge-triggered listener is only
+	// reported once so it is drained completely
+	for (unsigned long accepted = 0;
+		 accepted < _config.acceptBatch || _loop->edgeTriggered(); accepted++) {
 		std::pair<int, std::string> connectionInfo = acceptConnection();
+		if (connectionInfo.first == -1) {
+			break;
+		}
 		addClient(connectionInfo.first, connectionInfo.second);
-	} else {
-		memset(_buffer, 0, 1024);
-		int bytesRead = recv(pollFds[index].fd, _buffer, sizeof(_buffer) - 1,
-							 0);
+	}
+}
+
+void Server::receiveData(int fd) {
+	Client *client = findClient(fd);
+	if (!client) {
+		return;
+	}
+	// the socket is drained until EAGAIN, straight into the client's buffer
+	while (true) {
+		size_t available;
+		char *space = client->recvSpace(available);
+		ssize_t bytesRead = recv(fd, space, available, 0);
 		if (bytesRead > 0) {
-			_buffer[bytesRead] = 0;
-			if (parsBuffer(pollFds[index].fd)) {
-                clients[pollFds[index].fd]->setQuit(true);
-            }
-		} else if (bytesRead == 0) {
-			processQuit(pollFds[index].fd, std::vector<std::string>());
-			removeClient(pollFds[index].fd);
-			index--;
+			client->recvCommit(bytesRead);
+			if (!processInput(client)) {
+				break;
+			}
+		} else if (bytesRead == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			client->releaseRecvBuffer();
+			break;
 		} else {
-			throw std::runtime_error("Recv error: [" + std::string(strerror(errno)) + "]");
+			processQuit(fd, Message());
+			removeClient(fd);
+			break;
 		}
-		resetEvents(index);
 	}
-	return index;
 }
 
-void Server::sendData(size_t index) {
+// runs every complete buffered line, returns false once the client is quitting
+bool Server::processInput(Client *client) {
+	int fd = client->getSocket();
+	const char *line;
+	size_t length;
+	client->setLastActivity(_now);
+	while (!client->isQuit() && client->nextLine(line, length)) {
+		if (parsLine(fd, line, length)) {
+			client->setQuit(true);
+		}
+	}
+	return !client->isQuit();
+}
+
+void Server::sendData(int fd) {
+	Client *client = findClient(fd);
+	if (!client) {
+		return;
+	}
 	try {
-		Client &c = getClient(pollFds[index].fd);
-		if (!c.sendQueueEmpty()) {
-			std::string msg = c.popSendQueue();
-			const char *dataPtr = msg.c_str();
-			ssize_t dataRemaining = msg.length();
-			ssize_t n = send(pollFds[index].fd, dataPtr, dataRemaining, 0);
-			if (dataRemaining > n) {
-				c.pushSendQueue(msg.substr(n));
-				pollFds[index].events = POLLOUT;
+		Client &c = *client;
+		iovec iov[SEND_IOV_MAX];
+		size_t bytes;
+		while (!c.sendQueueEmpty()) {
+			int count = c.fillSendVector(iov, SEND_IOV_MAX, bytes);
+			if (_loop->completionBased()) {
+				for (int i = 0; i < count; i++) {
+					_loop->send(fd, static_cast<const char *>(iov[i].iov_base), iov[i].iov_len);
+				}
+				c.consumeSendQueue(bytes);
+				continue;
+			}
+			ssize_t n = writev(fd, iov, count);
+			if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+				break;
 			} else if (n < 0) {
+				processQuit(fd, Message());
+				removeClient(fd);
 				throw std::runtime_error("Send error");
-			} else if (n == 0) {
-				processQuit(pollFds[index].fd, std::vector<std::string>());
-				removeClient(pollFds[index].fd);
-				throw std::runtime_error("Connection closed");
+			}
+			c.consumeSendQueue(n);
+			if (static_cast<size_t>(n) < bytes) {
+				// socket buffer is full, the rest waits for the next write event
+				break;
 			}
 		}
-		if (c.isQuit()) {
-			close(pollFds[index].fd);
-			removeClient(pollFds[index].fd);
+		if (c.isQuit() && c.sendQueueEmpty()) {
+			removeClient(fd);
+		} else if (c.sendQueueEmpty()) {
+			_loop->modify(fd, EV_READ);
 		}
-		pollFds[index].events = POLLIN;
 	}
 	catch (std::exception &e) {
 		std::cout << "[ERR] " << e.what() << std::endl;
 	}
-	resetEvents(index);
-}
-
-void Server::resetEvents(size_t index) {
-	pollFds[index].revents = 0;
 }
 
 void Server::listenPort() const {
@@ -259,41 +453,53 @@ void Server::listenPort() const {
 std::pair<int, std::string> Server::acceptConnection() {
 	sockaddr_in clientAddress;
 	socklen_t clientAddressLength = sizeof(clientAddress);
-	pollfd clientPollFd;
+	char hostname[INET_ADDRSTRLEN];
 
-	// accept connection and dd the new client's socket to the pollFds container
+	// accept connection, the caller registers the new client's socket in the event loop
+#ifdef __linux__
+	int clientSocket = accept4(socketFd, (sockaddr *) (&clientAddress),
+							   &clientAddressLength, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
 	int clientSocket = accept(socketFd, (sockaddr *) (&clientAddress),
 							  &clientAddressLength);
+	if (clientSocket != -1 && fcntl(clientSocket, F_SETFL, O_NONBLOCK) == -1) {
+		close(clientSocket);
+		throw std::runtime_error(
+			"Fcntl error: [" + std::string(strerror(errno)) + "]");
+	}
+#endif
 	if (clientSocket == -1) {
+		if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ECONNABORTED) {
+			return std::make_pair(-1, std::string());
+		}
 		throw std::runtime_error(
 			"Accept error: [" + std::string(strerror(errno)) + "]");
 	}
-	if (fcntl(socketFd, F_SETFL, O_NONBLOCK) == -1) {
-		// Handle error
-		throw std::runtime_error(
-			"Fcntl error: [" + std::string(strerror(errno)) + "]");
+	if (!inet_ntop(AF_INET, &clientAddress.sin_addr, hostname, sizeof(hostname))) {
+		return std::make_pair(clientSocket, std::string("unknown"));
+	}
+	return std::make_pair(clientSocket, std::string(hostname));
+}
+
+std::string Server::peerHostname(int fd) {
+	sockaddr_in peerAddress;
+	socklen_t peerAddressLength = sizeof(peerAddress);
+	char hostname[INET_ADDRSTRLEN];
+	if (getpeername(fd, (sockaddr *) (&peerAddress), &peerAddressLength) == -1
+		|| !inet_ntop(AF_INET, &peerAddress.sin_addr, hostname, sizeof(hostname))) {
+		return "unknown";
 	}
-	clientPollFd.fd = clientSocket;
-	clientPollFd.events = POLLIN;
-	clientPollFd.revents = 0;
-	pollFds.push_back(clientPollFd);
-	// print information about the accepted connection
-	std::cout << "Accepted connection from: "
-			  << inet_ntoa(clientAddress.sin_addr) << ":"
-			  << ntohs(clientAddress.sin_port)
-			  << " at fd=" << clientSocket << std::endl;
-	return std::make_pair(clientSocket, inet_ntoa(clientAddress.sin_addr));
+	return hostname;
 }
 
 // Channel getters
 
-std::string Server::getNickAndHostname(int fd) {
-	std::string  res = clients[fd]->getNickname() + "@" + clients[fd]->getHostname();
-	return res;
+const std::string &Server::getPrefix(int fd) {
+	return clients[fd]->getPrefix();
 }
 
 std::string Server::getNick(int fd) {
-	if (clients.find(fd) != clients.end()) {
+	if (clients[fd]) {
 		std::string nick = clients[fd]->getNickname();
 		return nick;
 	}
@@ -301,70 +507,139 @@ std::string Server::getNick(int fd) {
 }
 
 void Server::addChannel(Channel *channel) {
-	_channels.push_back(channel);
+	_channels[channel->getName()] = channel;
+	_directory.insert(DirectoryKey(channel->getMemberCount(), channel->getName()));
 }
 
-void Server::removeChannel(const std::string &channelName) {
-	for (std::vector<Channel *>::iterator it = _channels.begin(); it != _channels.end(); ++it) {
-		if ((*it)->getName() == Server::uncapitalizeString(channelName)) {
-			delete *it;
-			_channels.erase(it);
-			break;
+// moves the channel to its place for the new member count
+void Server::updateDirectory(Channel *channel, size_t previousCount) {
+	_directory.erase(DirectoryKey(previousCount, channel->getName()));
+	if (channel->getMemberCount()) {
+		_directory.insert(DirectoryKey(channel->getMemberCount(), channel->getName()));
+	}
+}
+
+void Server::removeChannel(Channel *channel) {
+	// entries left are pending invites, their clients drop the handle
+	const std::vector<Member> &members = channel->getMembers();
+	for (std::vector<Member>::const_iterator it = members.begin(); it != members.end(); ++it) {
+		if ((it->flags & MEMBER_INVITED) && clients[it->fd]) {
+			clients[it->fd]->removeInvite(channel);
 		}
 	}
+	_channels.erase(channel->getName());
+	_directory.erase(DirectoryKey(channel->getMemberCount(), channel->getName()));
+	delete channel;
 }
 
 Channel *Server::findChannel(const std::string &name) {
-	std::string lowerName = uncapitalizeString(name);
-	for (std::vector<Channel *>::iterator it = _channels.begin(); it != _channels.end(); ++it) {
-		if ((*it)->getName() == lowerName) {
-			return *it;
-		}
+	return findFoldedChannel(uncapitalizeString(name));
+}
+
+// for names that are already lowercased, like Channel::getName()
+Channel *Server::findFoldedChannel(const std::string &foldedName) {
+	ChannelMap::iterator it = _channels.find(foldedName);
+	if (it == _channels.end()) {
+		return NULL;
 	}
-	return NULL;
+	return it->second;
 }
 
+// every channel, ordered by name
 void Server::removeClientFromChannel(int fd, Channel *channel) {
+	size_t previousCount = channel->getMemberCount();
 	channel->removeMember(fd);
-	clients[fd]->removeChannel(channel->getName());
-	if (channel->getMemberFds().empty()) {
-		removeChannel(channel->getName());
+	clients[fd]->removeChannel(channel);
+	updateDirectory(channel, previousCount);
+	if (!channel->getMemberCount()) {
+		removeChannel(channel);
+	}
+}
+
+// clients sharing at least one channel with the given one, each listed once:
+// a client is taken the first time it is seen with the current epoch
+const std::vector<int> &Server::channelNeighbours(Client *client, bool includeSelf) {
+	if (++_epoch == 0) {
+		// wrapped around, stale marks could collide with the new epochs
+		for (std::vector<int>::const_iterator it = clients.fds().begin(); it != clients.fds().end(); ++it) {
+			clients[*it]->setMark(0);
+		}
+		_epoch = 1;
+	}
+	_neighbours.clear();
+	client->setMark(_epoch);
+	if (includeSelf) {
+		_neighbours.push_back(client->getSocket());
+	}
+	const std::vector<Channel *> &channels = client->getChannels();
+	for (std::vector<Channel *>::const_iterator it = channels.begin(); it != channels.end(); ++it) {
+		const std::vector<Member> &members = (*it)->getMembers();
+		for (std::vector<Member>::const_iterator member = members.begin(); member != members.end(); ++member) {
+			if (!(member->flags & MEMBER_JOINED)) {
+				continue;
+			}
+			Client *neighbour = clients[member->fd];
+			if (neighbour->getMark() != _epoch) {
+				neighbour->setMark(_epoch);
+				_neighbours.push_back(member->fd);
+			}
+		}
 	}
+	return _neighbours;
 }
 
-std::vector<Channel *> Server::findChannels(std::queue<std::string> names) {
+void Server::inviteClient(Client *client, Channel *channel) {
+	if (!channel->hasInvited(client->getSocket())) {
+		channel->addInvited(client->getSocket());
+		client->addInvite(channel);
+	}
+}
+
+std::vector<Channel *> Server::findChannels(const std::vector<std::string> &names) {
 	std::vector<Channel *> channels;
-	while (!names.empty()) {
-		Channel *channel = findChannel(names.front());
+	for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+		Channel *channel = findChannel(*it);
 		if (channel) {
 			channels.push_back(channel);
 		}
-		names.pop();
 	}
 	return channels;
 }
 
+// only registered clients are indexed, lookups fold the nickname once
 Client *Server::findClient(const std::string &nickname) {
-	std::string lowerNickname = uncapitalizeString(nickname);
-	for (std::map<int, Client *>::iterator it = clients.begin(); it != clients.end(); ++it) {
-		if ( it->second->getNickname() == lowerNickname) {
-			return it->second;
-		}
+	std::map<std::string, Client *>::iterator it = _nicknames.find(uncapitalizeString(nickname));
+	if (it == _nicknames.end()) {
+		return NULL;
 	}
-	return NULL;
+	return it->second;
 }
 
-Client *Server::findClient(int fd) {
-	std::map<int, Client *>::iterator it = clients.find(fd);
-	if (it == clients.end()) {
-		return NULL;
+void Server::renameClient(Client *client, const std::string &nickname) {
+	std::map<std::string, Client *>::iterator it = _nicknames.find(client->getNickname());
+	if (it != _nicknames.end() && it->second == client) {
+		_nicknames.erase(it);
+		indexHost(client, false);
+	}
+	client->setNickname(nickname);
+	_nicknames[client->getNickname()] = client;
+	indexHost(client, true);
+	const std::vector<Channel *> &channels = client->getChannels();
+	for (size_t i = 0; i < channels.size(); i++) {
+		channels[i]->renameMember(client->getSocket(), client->getNickname());
 	}
-	return it->second;
 }
 
-Client &Server::getClient(int fd) {
-	if (clients.find(fd) == clients.end()) {
-		throw std::runtime_error("Cannot find client with fd");
+// WHO restricted to hosts walks this index from the mask prefix
+void Server::indexHost(Client *client, bool add) {
+	std::pair<std::string, std::string> key(uncapitalizeString(client->getHostname()), client->getNickname());
+	if (add) {
+		_hosts.insert(key);
+	} else {
+		_hosts.erase(key);
 	}
-	return (*this->clients[fd]);
+}
+
+Client *Server::findClient(int fd) {
+	return clients[fd];
 }
@@ -0,0 +1,130 @@
+#include <ctime>
+#include "../headers/TimerWheel.hpp"
+
+Timer::Timer() : next(NULL), prev(NULL), expires(0), fd(-1), kind(TIMER_IDLE) {
+}
+
+bool Timer::pending() const {
+	return next != NULL;
+}
+
+TimerWheel::TimerWheel(unsigned long tickMs)
+	: _originMs(now()),
+	  _tickMs(tickMs),
+	  _tick(0),
+	  _count(0) {
+	for (int level = 0; level < WHEEL_LEVELS; level++) {
+		for (int slot = 0; slot < WHEEL_SIZE; slot++) {
+			_slots[level][slot].next = &_slots[level][slot];
+			_slots[level][slot].prev = &_slots[level][slot];
+		}
+	}
+}
+
+unsigned long TimerWheel::now() {
+	timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000UL + ts.tv_nsec / 1000000UL;
+}
+
+void TimerWheel::link(Timer &head, Timer &timer) {
+	timer.prev = head.prev;
+	timer.next = &head;
+	head.prev->next = &timer;
+	head.prev = &timer;
+}
+
+void TimerWheel::unlink(Timer &timer) {
+	timer.prev->next = timer.next;
+	timer.next->prev = timer.prev;
+	timer.next = NULL;
+	timer.prev = NULL;
+}
+
+void TimerWheel::place(Timer &timer) {
+	// the level is chosen by the distance to the current tick, the slot by the expiry tick itself
+	unsigned long delta = timer.expires - _tick;
+	if (timer.expires < _tick) {
+		link(_slots[0][_tick & WHEEL_MASK], timer);
+		return;
+	}
+	for (int level = 0; level < WHEEL_LEVELS; level++) {
+		if (delta < (1UL << (WHEEL_BITS * (level + 1))) || level == WHEEL_LEVELS - 1) {
+			link(_slots[level][(timer.expires >> (WHEEL_BITS * level)) & WHEEL_MASK], timer);
+			return;
+		}
+	}
+}
+
+void TimerWheel::cascade(int level) {
+	// re-places the timers of the upper level slot that the lower levels just caught up with
+	Timer &head = _slots[level][(_tick >> (WHEEL_BITS * level)) & WHEEL_MASK];
+	while (head.next != &head) {
+		Timer *timer = head.next;
+		unlink(*timer);
+		place(*timer);
+	}
+}
+
+void TimerWheel::schedule(Timer &timer, unsigned long delayMs) {
+	unsigned long maxTicks = (1UL << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+	unsigned long ticks = (delayMs + _tickMs - 1) / _tickMs;
+	if (timer.pending()) {
+		cancel(timer);
+	}
+	timer.expires = _tick + (ticks < maxTicks ? ticks : maxTicks);
+	place(timer);
+	_count++;
+}
+
+void TimerWheel::cancel(Timer &timer) {
+	if (!timer.pending()) {
+		return;
+	}
+	unlink(timer);
+	_count--;
+}
+
+void TimerWheel::advance(unsigned long nowMs, std::vector<Timer *> &expired) {
+	expired.clear();
+	unsigned long target = (nowMs - _originMs) / _tickMs;
+	while (_tick <= target) {
+		if (_count == 0) {
+			// nothing to expire: jump straight to the target tick
+			_tick = target + 1;
+			break;
+		}
+		int index = _tick & WHEEL_MASK;
+		for (int level = 1; level < WHEEL_LEVELS && index == 0; level++) {
+			cascade(level);
+			index = (_tick >> (WHEEL_BITS * level)) & WHEEL_MASK;
+		}
+		Timer &head = _slots[0][_tick & WHEEL_MASK];
+		_tick++;
+		while (head.next != &head) {
+			Timer *timer = head.next;
+			unlink(*timer);
+			_count--;
+			expired.push_back(timer);
+		}
+	}
+}
+
+int TimerWheel::nextTimeout(unsigned long nowMs) const {
+	if (_count == 0) {
+		return -1;
+	}
+	unsigned long tick = _tick;
+	// the first non empty level 0 slot, or the next cascade which may refill level 0
+	for (int i = 0; i < WHEEL_SIZE; i++, tick++) {
+		const Timer &head = _slots[0][tick & WHEEL_MASK];
+		if (head.next != &head || (tick & WHEEL_MASK) == 0) {
+			break;
+		}
+	}
+	unsigned long deadline = _originMs + tick * _tickMs;
+	if (deadline <= nowMs) {
+		return 0;
+	}
+	return static_cast<int>(deadline - nowMs);
+}
@@ -0,0 +1,482 @@
+#include "../headers/UringLoop.hpp"
+
+#ifdef __linux__
+
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <csignal>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+
+enum UringOp {
+	OP_ACCEPT = 1,
+	OP_RECV,
+	OP_SEND,
+	OP_CANCEL
+};
+
+static const unsigned short URING_BUFFER_GROUP = 0;
+
+// user_data layout: operation (8 bits) | connection generation (24 bits) | fd (32 bits)
+static unsigned long long encode(unsigned int op, unsigned int generation, int fd) {
+	return (static_cast<unsigned long long>(op) << 56)
+		   | (static_cast<unsigned long long>(generation & 0xffffff) << 32)
+		   | static_cast<unsigned int>(fd);
+}
+
+static int uringSetup(unsigned int entries, io_uring_params *params) {
+	return syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uringEnter(int ringFd, unsigned int toSubmit, unsigned int minComplete,
+					  unsigned int flags, void *arg, size_t argSize) {
+	return syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, arg, argSize);
+}
+
+static int uringRegister(int ringFd, unsigned int opcode, void *arg, unsigned int nrArgs) {
+	return syscall(__NR_io_uring_register, ringFd, opcode, arg, nrArgs);
+}
+
+static std::runtime_error uringError(const std::string &what) {
+	return std::runtime_error("io_uring " + what + ": [" + std::string(strerror(errno)) + "]");
+}
+
+UringLoop::Connection::Connection()
+	: generation(0),
+	  receiving(false),
+	  closing(false),
+	  sendOffset(0) {
+}
+
+UringLoop::UringLoop()
+	: _ringFd(-1),
+	  _listenFd(-1),
+	  _ringMap(MAP_FAILED),
+	  _ringMapSize(0),
+	  _sqes(static_cast<io_uring_sqe *>(MAP_FAILED)),
+	  _sqesSize(0),
+	  _sqLocalTail(0),
+	  _bufRing(static_cast<io_uring_buf *>(MAP_FAILED)),
+	  _bufRingSize(0),
+	  _buffers(NULL),
+	  _bufTail(0) {
+	try {
+		probe();
+		setup();
+		setupBuffers();
+	} catch (std::exception &) {
+		teardown();
+		throw;
+	}
+}
+
+UringLoop::~UringLoop() {
+	teardown();
+}
+
+void UringLoop::probe() {
+	// multishot recv and provided buffer rings need 6.0
+	utsname system;
+	if (uname(&system) == -1 || atoi(system.release) < 6) {
+		throw std::runtime_error("io_uring: kernel lacks multishot recv");
+	}
+}
+
+void UringLoop::setup() {
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	_ringFd = uringSetup(URING_ENTRIES, &params);
+	if (_ringFd < 0) {
+		throw uringError("setup");
+	}
+	if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)
+		|| !(params.features & IORING_FEAT_NODROP)) {
+		throw std::runtime_error("io_uring: missing required ring features");
+	}
+	size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	_ringMapSize = sqSize > cqSize ? sqSize : cqSize;
+	_ringMap = mmap(NULL, _ringMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+					_ringFd, IORING_OFF_SQ_RING);
+	if (_ringMap == MAP_FAILED) {
+		throw uringError("ring mmap");
+	}
+	_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	_sqes = static_cast<io_uring_sqe *>(mmap(NULL, _sqesSize, PROT_READ | PROT_WRITE,
+											 MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES));
+	if (_sqes == MAP_FAILED) {
+		throw uringError("sqes mmap");
+	}
+	char *ring = static_cast<char *>(_ringMap);
+	_sqEntries = params.sq_entries;
+	_sqHead = reinterpret_cast<unsigned int *>(ring + params.sq_off.head);
+	_sqTail = reinterpret_cast<unsigned int *>(ring + params.sq_off.tail);
+	_sqMask = *reinterpret_cast<unsigned int *>(ring + params.sq_off.ring_mask);
+	_sqArray = reinterpret_cast<unsigned int *>(ring + params.sq_off.array);
+	_sqLocalTail = *_sqTail;
+	_cqHead = reinterpret_cast<unsigned int *>(ring + params.cq_off.head);
+	_cqTail = reinterpret_cast<unsigned int *>(ring + params.cq_off.tail);
+	_cqMask = *reinterpret_cast<unsigned int *>(ring + params.cq_off.ring_mask);
+	_cqes = reinterpret_cast<io_uring_cqe *>(ring + params.cq_off.cqes);
+
+	// the operations this backend relies on
+	size_t probeSize = sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+	std::vector<char> probeBuffer(probeSize, 0);
+	io_uring_probe *ops = reinterpret_cast<io_uring_probe *>(&probeBuffer[0]);
+	if (uringRegister(_ringFd, IORING_REGISTER_PROBE, ops, 256) < 0) {
+		throw uringError("probe");
+	}
+	const unsigned char required[] = {IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_ASYNC_CANCEL};
+	for (size_t i = 0; i < sizeof(required); i++) {
+		if (required[i] > ops->last_op || !(ops->ops[required[i]].flags & IO_URING_OP_SUPPORTED)) {
+			throw std::runtime_error("io_uring: required operation not supported");
+		}
+	}
+}
+
+void UringLoop::setupBuffers() {
+	_bufRingSize = URING_BUFFERS * sizeof(io_uring_buf);
+	// io_uring_buf_ring is not used directly: its flexible array wrapper has a
+	// different layout in C++, where empty structs are not zero sized
+	_bufRing = static_cast<io_uring_buf *>(mmap(NULL, _bufRingSize, PROT_READ | PROT_WRITE,
+												MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+	if (_bufRing == MAP_FAILED) {
+		throw uringError("buffer ring mmap");
+	}
+	io_uring_buf_reg reg;
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = reinterpret_cast<unsigned long>(_bufRing);
+	reg.ring_entries = URING_BUFFERS;
+	reg.bgid = URING_BUFFER_GROUP;
+	if (uringRegister(_ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+		throw uringError("buffer ring registration");
+	}
+	_buffers = new char[URING_BUFFERS * URING_BUFFER_SIZE];
+	for (unsigned int bid = 0; bid < URING_BUFFERS; bid++) {
+		provideBuffer(bid);
+	}
+	__atomic_store_n(&_bufRing[0].resv, _bufTail, __ATOMIC_RELEASE);
+}
+
+void UringLoop::teardown() {
+	if (_ringFd >= 0) {
+		close(_ringFd);
+		_ringFd = -1;
+	}
+	if (_sqes != MAP_FAILED) {
+		munmap(_sqes, _sqesSize);
+		_sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+	}
+	if (_ringMap != MAP_FAILED) {
+		munmap(_ringMap, _ringMapSize);
+		_ringMap = MAP_FAILED;
+	}
+	if (_bufRing != MAP_FAILED) {
+		munmap(_bufRing, _bufRingSize);
+		_bufRing = static_cast<io_uring_buf *>(MAP_FAILED);
+	}
+	delete[] _buffers;
+	_buffers = NULL;
+	for (std::vector<Connection *>::iterator it = _connections.begin(); it != _connections.end(); ++it) {
+		delete *it;
+	}
+	_connections.clear();
+}
+
+const char *UringLoop::name() const {
+	return "io_uring";
+}
+
+bool UringLoop::edgeTriggered() const {
+	return false;
+}
+
+bool UringLoop::completionBased() const {
+	return true;
+}
+
+io_uring_sqe *UringLoop::getSqe() {
+	if (_sqLocalTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) >= _sqEntries) {
+		submit(0, 0);
+		if (_sqLocalTail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE) >= _sqEntries) {
+			throw std::runtime_error("io_uring: submission queue full");
+		}
+	}
+	unsigned int index = _sqLocalTail & _sqMask;
+	io_uring_sqe *sqe = &_sqes[index];
+	memset(sqe, 0, sizeof(*sqe));
+	_sqArray[index] = index;
+	_sqLocalTail++;
+	return sqe;
+}
+
+void UringLoop::submit(unsigned int waitFor, int timeoutMs) {
+	unsigned int toSubmit = _sqLocalTail - *_sqTail;
+	if (toSubmit == 0 && waitFor == 0) {
+		return;
+	}
+	__atomic_store_n(_sqTail, _sqLocalTail, __ATOMIC_RELEASE);
+	unsigned int flags = waitFor ? IORING_ENTER_GETEVENTS : 0;
+	int ret;
+	if (waitFor && timeoutMs >= 0) {
+		__kernel_timespec ts;
+		ts.tv_sec = timeoutMs / 1000;
+		ts.tv_nsec = (timeoutMs % 1000) * 1000000L;
+		io_uring_getevents_arg arg;
+		memset(&arg, 0, sizeof(arg));
+		arg.sigmask_sz = _NSIG / 8;
+		arg.ts = reinterpret_cast<unsigned long>(&ts);
+		ret = uringEnter(_ringFd, toSubmit, waitFor, flags | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+	} else {
+		ret = uringEnter(_ringFd, toSubmit, waitFor, flags, NULL, 0);
+	}
+	if (ret < 0 && errno != ETIME && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+		throw uringError("enter");
+	}
+}
+
+UringLoop::Connection &UringLoop::connection(int fd) {
+	if (fd >= static_cast<int>(_connections.size())) {
+		_connections.resize(fd + 1, NULL);
+	}
+	if (!_connections[fd]) {
+		_connections[fd] = new Connection();
+	}
+	return *_connections[fd];
+}
+
+void UringLoop::armAccept() {
+	io_uring_sqe *sqe = getSqe();
+	sqe->opcode = IORING_OP_ACCEPT;
+	sqe->fd = _listenFd;
+	sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+	sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+	sqe->user_data = encode(OP_ACCEPT, 0, _listenFd);
+}
+
+void UringLoop::armRecv(int fd) {
+	Connection &c = connection(fd);
+	io_uring_sqe *sqe = getSqe();
+	sqe->opcode = IORING_OP_RECV;
+	sqe->fd = fd;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = URING_BUFFER_GROUP;
+	sqe->user_data = encode(OP_RECV, c.generation, fd);
+	c.receiving = true;
+}
+
+void UringLoop::submitSend(int fd) {
+	Connection &c = connection(fd);
+	io_uring_sqe *sqe = getSqe();
+	sqe->opcode = IORING_OP_SEND;
+	sqe->fd = fd;
+	sqe->addr = reinterpret_cast<unsigned long>(c.sending.data() + c.sendOffset);
+	sqe->len = c.sending.size() - c.sendOffset;
+	// the last flush of a closing socket must not wait for a peer that stopped reading
+	sqe->msg_flags = MSG_NOSIGNAL | (c.closing ? MSG_DONTWAIT : 0);
+	sqe->user_data = encode(OP_SEND, c.generation, fd);
+}
+
+void UringLoop::cancel(int fd, unsigned int op) {
+	io_uring_sqe *sqe = getSqe();
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->addr = encode(op, connection(fd).generation, fd);
+	sqe->user_data = encode(OP_CANCEL, 0, fd);
+}
+
+void UringLoop::provideBuffer(unsigned short bid) {
+	io_uring_buf &buf = _bufRing[_bufTail & (URING_BUFFERS - 1)];
+	buf.addr = reinterpret_cast<unsigned long>(_buffers + bid * URING_BUFFER_SIZE);
+	buf.len = URING_BUFFER_SIZE;
+	buf.bid = bid;
+	_bufTail++;
+}
+
+void UringLoop::add(int fd, unsigned int events) {
+	if (events & EV_ACCEPT) {
+		_listenFd = fd;
+		armAccept();
+		return;
+	}
+	Connection &c = connection(fd);
+	c.closing = false;
+	armRecv(fd);
+}
+
+void UringLoop::modify(int fd, unsigned int events) {
+	// sends are submitted by the ring itself, there is no write interest to arm
+	(void) fd;
+	(void) events;
+}
+
+void UringLoop::remove(int fd) {
+	Connection &c = connection(fd);
+	if (c.receiving) {
+		cancel(fd, OP_RECV);
+		c.receiving = false;
+	}
+}
+
+void UringLoop::closeDescriptor(int fd) {
+	Connection &c = connection(fd);
+	remove(fd);
+	c.closing = true;
+	// staged bytes (an ERROR line for instance) get one last flush before the close
+	if (c.sending.empty() && c.staged.empty()) {
+		releaseConnection(fd);
+	}
+}
+
+void UringLoop::releaseConnection(int fd) {
+	Connection &c = connection(fd);
+	close(fd);
+	c.generation++;
+	c.closing = false;
+	c.sending.clear();
+	c.sendOffset = 0;
+	c.staged.clear();
+}
+
+void UringLoop::send(int fd, const char *data, size_t length) {
+	Connection &c = connection(fd);
+	if (c.sending.empty() && c.staged.empty()) {
+		_pendingSends.push_back(fd);
+	}
+	c.staged.append(data, length);
+}
+
+size_t UringLoop::pendingOutput(int fd) const {
+	if (fd < 0 || fd >= static_cast<int>(_connections.size()) || !_connections[fd]) {
+		return 0;
+	}
+	const Connection &c = *_connections[fd];
+	return c.sending.size() - c.sendOffset + c.staged.size();
+}
+
+void UringLoop::complete(const io_uring_cqe &cqe, std::vector<IoReady> &ready) {
+	unsigned int op = cqe.user_data >> 56;
+	unsigned int generation = (cqe.user_data >> 32) & 0xffffff;
+	int fd = static_cast<int>(cqe.user_data & 0xffffffff);
+	bool more = cqe.flags & IORING_CQE_F_MORE;
+	IoReady event;
+	event.fd = fd;
+	event.data = NULL;
+	event.length = 0;
+
+	if (op == OP_ACCEPT) {
+		if (cqe.res >= 0) {
+			connection(cqe.res).closing = false;
+			event.fd = cqe.res;
+			event.events = EV_ACCEPT;
+			ready.push_back(event);
+		}
+		if (!more && _listenFd >= 0) {
+			armAccept();
+		}
+	} else if (op == OP_RECV) {
+		Connection &c = connection(fd);
+		char *buffer = NULL;
+		if (cqe.flags & IORING_CQE_F_BUFFER) {
+			unsigned short bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+			_usedBuffers.push_back(bid);
+			buffer = _buffers + bid * URING_BUFFER_SIZE;
+		}
+		if (generation != (c.generation & 0xffffff) || c.closing || !c.receiving) {
+			return;
+		}
+		if (!more) {
+			c.receiving = false;
+		}
+		if (cqe.res > 0 && buffer) {
+			event.events = EV_READ;
+			event.data = buffer;
+			event.length = cqe.res;
+			ready.push_back(event);
+			if (!more) {
+				_pendingRecvs.push_back(fd);
+			}
+		} else if (cqe.res == -ENOBUFS) {
+			// every buffer is in use: re-armed once this batch has been consumed
+			_pendingRecvs.push_back(fd);
+		} else if (cqe.res != -ECANCELED) {
+			event.events = EV_CLOSE;
+			ready.push_back(event);
+		}
+	} else if (op == OP_SEND) {
+		Connection &c = connection(fd);
+		if (generation != (c.generation & 0xffffff)) {
+			return;
+		}
+		if (cqe.res < 0) {
+			c.sending.clear();
+			c.sendOffset = 0;
+			c.staged.clear();
+			if (c.closing) {
+				releaseConnection(fd);
+			} else {
+				event.events = EV_CLOSE;
+				ready.push_back(event);
+			}
+			return;
+		}
+		c.sendOffset += cqe.res;
+		if (c.sendOffset < c.sending.size()) {
+			submitSend(fd);
+			return;
+		}
+		c.sending.clear();
+		c.sendOffset = 0;
+		c.sending.swap(c.staged);
+		if (!c.sending.empty()) {
+			submitSend(fd);
+		} else if (c.closing) {
+			releaseConnection(fd);
+		}
+	}
+}
+
+void UringLoop::wait(std::vector<IoReady> &ready, int timeoutMs) {
+	ready.clear();
+	// the previous batch has been consumed: its buffers go back to the kernel
+	if (!_usedBuffers.empty()) {
+		for (std::vector<unsigned short>::iterator it = _usedBuffers.begin(); it != _usedBuffers.end(); ++it) {
+			provideBuffer(*it);
+		}
+		__atomic_store_n(&_bufRing[0].resv, _bufTail, __ATOMIC_RELEASE);
+		_usedBuffers.clear();
+	}
+	for (std::vector<int>::iterator it = _pendingRecvs.begin(); it != _pendingRecvs.end(); ++it) {
+		Connection &c = connection(*it);
+		if (!c.receiving && !c.closing) {
+			armRecv(*it);
+		}
+	}
+	_pendingRecvs.clear();
+	// one send per socket carrying everything staged during the last iteration
+	for (std::vector<int>::iterator it = _pendingSends.begin(); it != _pendingSends.end(); ++it) {
+		Connection &c = connection(*it);
+		if (c.sending.empty() && !c.staged.empty()) {
+			c.sending.swap(c.staged);
+			submitSend(*it);
+		}
+	}
+	_pendingSends.clear();
+
+	unsigned int head = *_cqHead;
+	bool available = head != __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+	submit(available || timeoutMs == 0 ? 0 : 1, timeoutMs);
+	unsigned int tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+	for (; head != tail; head++) {
+		complete(_cqes[head & _cqMask], ready);
+	}
+	__atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+}
+
+#endif
@@ -0,0 +1,45 @@
+#include "../headers/WhoQuery.hpp"
+
+WhoQuery::WhoQuery()
+	: match(WHO_MATCH_ALL),
+	  operatorsOnly(false) {
+}
+
+void WhoQuery::parse(const std::string &target, const std::string &options) {
+	this->target = target;
+	// "0" and a missing mask stand for everyone
+	mask = Mask(target.empty() || target == "0" ? "*" : target);
+	size_t percent = options.find('%');
+	std::string flags = options.substr(0, percent);
+	unsigned int selected = 0;
+	for (size_t i = 0; i < flags.size(); i++) {
+		switch (flags[i]) {
+			case 'n': selected |= WHO_MATCH_NICK; break;
+			case 'u': selected |= WHO_MATCH_USER; break;
+			case 'h':
+			case 'i': selected |= WHO_MATCH_HOST; break;
+			case 'r': selected |= WHO_MATCH_REALNAME; break;
+			case 's': selected |= WHO_MATCH_SERVER; break;
+			case 'o': operatorsOnly = true; break;
+		}
+	}
+	match = selected ? selected : static_cast<unsigned int>(WHO_MATCH_ALL);
+	if (percent == std::string::npos) {
+		return;
+	}
+	std::string whox = options.substr(percent + 1);
+	size_t comma = whox.find(',');
+	if (comma != std::string::npos) {
+		token = whox.substr(comma + 1);
+		whox.erase(comma);
+	}
+	for (const char *field = WHOX_FIELDS; *field; field++) {
+		if (whox.find(*field) != std::string::npos) {
+			fields += *field;
+		}
+	}
+	if (fields.empty()) {
+		// "%" alone still asks for the WHOX reply, with the usual fields
+		fields = "cuhsnfdr";
+	}
+}
@@ -0,0 +1,8 @@
+#include "../../headers/Server.hpp"
+
+// capability negotiation is not supported: CAP LS advertises an empty list
+void Server::processCap(int fd, const Message &message) {
+	if (!clients[fd]->isRegistered() && message.paramCount && message.params[0] == "LS") {
+		serverSendReply(fd, "", CAPLS, "");
+	}
+}
\ No newline at end of file
@@ -1,13 +1,13 @@
 #include "../../headers/Server.hpp"
 
-void Server::processInvite(int fd, const std::vector<std::string> &tokens) {
-	if (tokens.size() < 3) {
+void Server::processInvite(int fd, const Message &message) {
+	if (message.paramCount < 2) {
 		serverSendError(fd, "INVITE", ERR_NEEDMOREPARAMS);
 		return;
 	}
 
-	const std::string &invitedNick = tokens[1];
-	const std::string &channelName = tokens[2];
+	const std::string invitedNick = message.params[0].str();
+	const std::string channelName = message.params[1].str();
 	Client *invitedClient = findClient(invitedNick);
 	Channel *channel = findChannel(channelName);
 	std::string parameters = invitedNick + " " + channelName;
@@ -25,9 +25,9 @@ void Server::processInvite(int fd, const std::vector<std::string> &tokens) {
 				serverSendError(fd, channelName, ERR_CHANOPRIVSNEEDED);
 				return;
 			}
-			channel->addInvited(invitedClient->getSocket());
+			inviteClient(invitedClient, channel);
 		}
-		serverSendNotification(invitedClient->getSocket(), getNickAndHostname(fd), "INVITE", parameters);
+		serverSendNotification(invitedClient->getSocket(), getPrefix(fd), "INVITE", parameters);
 		serverSendReply(fd, parameters, RPL_INVITING, "");
 		if (invitedClient->activeMode(AWAY)) {
 			serverSendReply(fd, invitedNick, RPL_AWAY, invitedClient->getAwayMessage());
@@ -1,22 +1,25 @@
 #include "../../headers/Server.hpp"
 
-void Server::processJoin(int fd, const std::vector<std::string> &tokens) {
-	if (tokens.size() < 2) {
+void Server::processJoin(int fd, const Message &message) {
+	if (message.paramCount < 1) {
 		serverSendError(fd, "JOIN", ERR_NEEDMOREPARAMS);
 		return;
 	}
 
-	std::queue<std::string> channels = split(tokens[1], ',', true);
+	std::vector<std::string> channels;
+	split(message.params[0].str(), ',', true, channels);
 	if (channels.size() > MAXTARGETS) {
 		serverSendError(fd, "JOIN", ERR_TOOMANYTARGETS);
 		return;
 	}
-	std::queue<std::string> passwords = (tokens.size() > 2) ? split(tokens[2], ',', false) : std::queue<std::string>();
-	while (!channels.empty()) {
-		std::string channelName = channels.front();
-		channels.pop();
-		std::string password = !passwords.empty() ? passwords.front() : "";
-		if (!passwords.empty()) passwords.pop();
+	std::vector<std::string> passwords;
+	if (message.paramCount > 1) {
+		split(message.params[1].str(), ',', false, passwords);
+	}
+	static const std::string noPassword;
+	for (size_t i = 0; i < channels.size(); i++) {
+		const std::string &channelName = channels[i];
+		const std::string &password = i < passwords.size() ? passwords[i] : noPassword;
 		if (findClient(fd)->getChannels().size() == MAXCHANNELS) {
 			serverSendError(fd, channelName, ERR_TOOMANYCHANNELS);
 			return;
@@ -30,7 +33,7 @@ void Server::processJoin(int fd, const std::vector<std::string> &tokens) {
 	}
 }
 
-void Server::joinExistingChannel(int fd, Channel *channel, std::string password) {
+void Server::joinExistingChannel(int fd, Channel *channel, const std::string &password) {
 	if (channel->hasMember(fd)) {
 		return;
 	}
@@ -38,24 +41,26 @@ void Server::joinExistingChannel(int fd, Channel *channel, std::string password)
 		serverSendError(fd, channel->getName(), ERR_INVITEONLYCHAN);
 		return;
 	}
-	if (channel->isModeSet(LIMITSET) && (int) channel->getMemberFds().size() == channel->getLimitMembers()) {
+	if (channel->isModeSet(LIMITSET) && (int) channel->getMemberCount() == channel->getLimitMembers()) {
 		serverSendError(fd, channel->getName(), ERR_CHANNELISFULL);
 		return;
 	}
-	if (channel->authMember(fd, password)) { // checking password and removing from invited container
-		clients[fd]->addChannel(channel->getName());
+	if (channel->authMember(clients[fd], password)) { // checking password and removing from invited container
+		clients[fd]->removeInvite(channel);
+		clients[fd]->addChannel(channel);
+		updateDirectory(channel, channel->getMemberCount() - 1);
 		sendJoinNotificationsAndReplies(fd, channel);
 	} else {
 		serverSendError(fd, channel->getName(), ERR_BADCHANNELKEY);
 	}
 }
 
-void Server::createAndJoinNewChannel(int fd, std::string channelName, std::string password) {
+void Server::createAndJoinNewChannel(int fd, const std::string &channelName, const std::string &password) {
 	if (isValidChannelName(channelName)) {
-		Channel *newChannel = new Channel(channelName, password);
-		newChannel->addMember(fd);
+		Channel *newChannel = new Channel(channelName, password, namesLimit(channelName));
+		newChannel->addMember(clients[fd]);
 		newChannel->addOperator(fd);
-		clients[fd]->addChannel(channelName);
+		clients[fd]->addChannel(newChannel);
 		addChannel(newChannel);
 		sendJoinNotificationsAndReplies(fd, newChannel);
 	} else {
@@ -64,14 +69,13 @@ void Server::createAndJoinNewChannel(int fd, std::string channelName, std::strin
 }
 
 void Server::sendJoinNotificationsAndReplies(int fd, const Channel *channel) {
-	serverSendNotification(channel->getMemberFds(), getNickAndHostname(fd), "JOIN", channel->getName());
+	serverSendNotification(channel, getPrefix(fd), "JOIN", channel->getName());
 	if (!channel->getTopic().empty()) {
 		serverSendReply(fd, channel->getName(), RPL_TOPIC, channel->getTopic());
 	} else {
         serverSendReply(fd, channel->getName(), RPL_NOTOPIC, "");
     }
-	std::string nicknamesString = mergeTokensToString(getAllChannelMembersNicks(channel), false);
-	serverSendReply(fd, channel->getName(), RPL_NAMREPLY, nicknamesString);
+	sendNames(fd, channel);
 	serverSendReply(fd, channel->getName(), RPL_ENDOFNAMES, "");
 }
 
@@ -1,18 +1,16 @@
 #include "../../headers/Server.hpp"
 
-void Server::processKick(int fd, const std::vector<std::string> &tokens) {
-	if (tokens.size() < 3) {
+void Server::processKick(int fd, const Message &message) {
+	if (message.paramCount < 2) {
 		serverSendError(fd, "KICK", ERR_NEEDMOREPARAMS);
 		return;
 	}
 
-	const std::string &channelName = tokens[1];
-	const std::string &targetNick = tokens[2];
+	const std::string channelName = message.params[0].str();
+	const std::string targetNick = message.params[1].str();
 	std::string reason = targetNick;
-	if (tokens.size() > 3) {
-		reason = tokens[3].at(0) == ':'
-				 ? mergeTokensToString(std::vector<std::string>(tokens.begin() + 3, tokens.end()), true)
-				 : tokens[3];
+	if (message.paramCount > 2) {
+		reason = message.params[2].str();
 	}
 	Channel *channel = findChannel(channelName);
 	if (!channel) {
@@ -27,7 +25,7 @@ void Server::processKick(int fd, const std::vector<std::string> &tokens) {
 			serverSendError(fd, targetNick + " " + channelName, ERR_USERNOTINCHANNEL);
 		} else {
 			std::string parameters = channelName + " " + targetNick + " :" + reason;
-			serverSendNotification(channel->getMemberFds(), getNickAndHostname(fd), "KICK", parameters);
+			serverSendNotification(channel, getPrefix(fd), "KICK", parameters);
 			removeClientFromChannel(targetClient->getSocket(), channel);
 		}
 	}
@@ -1,27 +1,96 @@
 #include "../../headers/Server.hpp"
 
-void Server::processList(int fd, const std::vector<std::string> &tokens) {
-	if (tokens.size() == 1) {
-		listChannels(fd, _channels);
-	} else {
-		std::queue<std::string> channelNames = split(tokens[1], ',', true);
-		if (channelNames.size() > MAXTARGETS) {
+// LIST [<channel>|<condition>{,<channel>|<condition>}]: named channels are
+// answered at once, otherwise the directory is paged through
+void Server::processList(int fd, const Message &message) {
+	ListFilter filter;
+	std::vector<Channel *> channels;
+	bool named = false;
+	if (message.paramCount > 0) {
+		std::vector<std::string> tokens;
+		split(message.params[0].str(), ',', true, tokens);
+		if (tokens.size() > MAXTARGETS) {
 			serverSendError(fd, "LIST", ERR_TOOMANYTARGETS);
 			return;
 		}
-		std::vector<Channel *> channels = findChannels(channelNames);
-		listChannels(fd, channels);
+		for (std::vector<std::string>::const_iterator it = tokens.begin(); it != tokens.end(); ++it) {
+			if (filter.add(*it)) {
+				continue;
+			}
+			named = true;
+			Channel *channel = findChannel(*it);
+			if (channel) {
+				channels.push_back(channel);
+			}
+		}
+	}
+	if (!named) {
+		startListing(fd, filter);
+		return;
+	}
+	time_t now = time(NULL);
+	for (std::vector<Channel *>::const_iterator it = channels.begin(); it != channels.end(); ++it) {
+		if (filter.matches(**it, now)) {
+			sendListEntry(fd, *it);
+		}
 	}
 	serverSendReply(fd, "", RPL_LISTEND, "");
 }
 
-void Server::listChannels(int fd, std::vector<Channel *> &channels) {
-	for (std::vector<Channel *>::const_iterator it = channels.begin(); it != channels.end(); ++it) {
-		std::stringstream clientCount;
-		clientCount << (*it)->getMemberFds().size();
-		serverSendReply(fd,
-						(*it)->getName() + " " + clientCount.str(),
-						RPL_LIST,
-						!(*it)->getTopic().empty() ? (*it)->getTopic() : "");
-	}
-}
\ No newline at end of file
+void Server::sendListEntry(int fd, const Channel *channel) {
+	char count[24];
+	snprintf(count, sizeof(count), " %lu", static_cast<unsigned long>(channel->getMemberCount()));
+	serverSendReply(fd, channel->getName() + count, RPL_LIST, channel->getTopic());
+}
+
+// the first page is queued right away, a new LIST replaces one in progress
+void Server::startListing(int fd, const ListFilter &filter) {
+	for (std::vector<ListPager>::iterator it = _listings.begin(); it != _listings.end(); ++it) {
+		if (it->client.fd == fd) {
+			_listings.erase(it);
+			break;
+		}
+	}
+	ListPager pager;
+	pager.client = clients.handle(fd);
+	pager.filter = filter;
+	pager.started = false;
+	if (listNextPage(pager)) {
+		_listings.push_back(pager);
+	}
+}
+
+// queues up to LIST_PAGE_SIZE entries after the cursor, false once RPL_LISTEND went out
+bool Server::listNextPage(ListPager &pager) {
+	const ListFilter &filter = pager.filter;
+	ChannelDirectory::const_iterator it;
+	if (pager.started) {
+		it = _directory.upper_bound(pager.cursor);
+	} else if (filter.lessThan) {
+		// larger channels come first, the smaller ones start here
+		it = _directory.lower_bound(DirectoryKey(filter.lessThan - 1, ""));
+	} else {
+		it = _directory.begin();
+	}
+	pager.started = true;
+	time_t now = time(NULL);
+	size_t sent = 0;
+	for (size_t scanned = 0; it != _directory.end() && scanned < LIST_SCAN_LIMIT && sent < LIST_PAGE_SIZE;
+		 ++it, ++scanned) {
+		if (it->first <= filter.moreThan) {
+			it = _directory.end();
+			break;
+		}
+		pager.cursor = *it;
+		Channel *channel = findFoldedChannel(it->second);
+		if (channel && filter.matches(*channel, now)) {
+			sendListEntry(pager.client.fd, channel);
+			sent++;
+		}
+	}
+	if (it == _directory.end()) {
+		serverSendReply(pager.client.fd, "", RPL_LISTEND, "");
+		return false;
+	}
+	return true;
+}
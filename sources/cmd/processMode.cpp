@@ -1,25 +1,25 @@
 #include "../../headers/Server.hpp"
 
-void Server::processMode(int fd, const std::vector<std::string> &tokens) {
-	if (tokens.size() < 2) {
+void Server::processMode(int fd, const Message &message) {
+	if (message.paramCount < 1) {
 		serverSendError(fd, "MODE", ERR_NEEDMOREPARAMS);
 		return;
 	}
 
-	if (tokens[1].at(0) == '#' || tokens[1].at(0) == '&') {
-		processChannelMode(fd, tokens);
+	if (message.params[0].first() == '#' || message.params[0].first() == '&') {
+		processChannelMode(fd, message);
 	} else {
-		processUserMode(fd, tokens);
+		processUserMode(fd, message);
 	}
 }
 
-void Server::processChannelMode(int fd, const std::vector<std::string> &tokens) {
-	const std::string &channelName = tokens[1];
+void Server::processChannelMode(int fd, const Message &message) {
+	const std::string channelName = message.params[0].str();
 	Channel *channel = findChannel(channelName);
 	std::string nickname = getNick(fd);
 	if (!channel) {
 		serverSendError(fd, channelName, ERR_NOSUCHCHANNEL);
-	} else if (tokens.size() == 2) {
+	} else if (message.paramCount == 1) {
 		if (channel->hasMember(fd)) {
 			serverSendReply(fd, channelName + " " + channel->getModeStringWithParameters(), RPL_CHANNELMODEIS, "");
 		} else {
@@ -30,12 +30,12 @@ void Server::processChannelMode(int fd, const std::vector<std::string> &tokens)
 	} else if (!channel->hasOperator(fd)) {
 		serverSendError(fd, channelName, ERR_CHANOPRIVSNEEDED);
 	} else {
-		std::string modes = tokens[2];
+		std::string modes = message.params[1].str();
 		std::string changedModes;
 		std::vector<std::string> parametersSet;
 		char settingMode = '+';
 		char lastSettingMode = '+';
-		size_t paramIndex = 3;
+		size_t paramIndex = 2;
 
 		for (size_t i = 0; i < modes.length(); ++i) {
 			char mode = modes.at(i);
@@ -43,15 +43,15 @@ void Server::processChannelMode(int fd, const std::vector<std::string> &tokens)
 				settingMode = mode;
 				continue; // go to the next iteration to process the channelMode character
 			}
-			std::string parameter = (modeParameterNeeded(settingMode, mode) && paramIndex < tokens.size())
-									? tokens[paramIndex++]
+			std::string parameter = (modeParameterNeeded(settingMode, mode) && paramIndex < message.paramCount)
+									? message.params[paramIndex++].str()
 									: ""; // check if the channelMode requires a parameter and take it
-			ModeHandlerIterator it = channelMode.find(mode);
-			if (it == channelMode.end()) { // check if mode is known
+			ModeHandler handler = channelMode[static_cast<unsigned char>(mode)];
+			if (!handler) { // check if mode is known
 				serverSendError(fd, std::string(1, mode), ERR_UNKNOWNMODE);
 				continue;
 			}
-			if ((this->*(it->second))(settingMode, parameter, channel, fd)) { // if channelMode applied successfully
+			if ((this->*handler)(settingMode, parameter, channel, fd)) { // if channelMode applied successfully
 				parametersSet.push_back(parameter);
 				if (lastSettingMode != settingMode) { // add + or - if it changed since last channelMode flag
 					changedModes += settingMode;
@@ -61,8 +61,8 @@ void Server::processChannelMode(int fd, const std::vector<std::string> &tokens)
 			}
 		}
 		if (!changedModes.empty()) {
-			std::string parameters = channelName + " " + changedModes + " " + mergeTokensToString(parametersSet, false);
-			serverSendNotification(channel->getMemberFds(), getNickAndHostname(fd), "MODE", parameters);
+			std::string parameters = channelName + " " + changedModes + " " + mergeTokensToString(parametersSet);
+			serverSendNotification(channel, getPrefix(fd), "MODE", parameters);
 		}
 	}
 }
@@ -114,7 +114,7 @@ bool Server::handleModeL(char set, const std::string &parameter, Channel *channe
 	if (set == '+') {
 		std::istringstream iss(parameter);
 		int limit;
-		if (!(iss >> limit) || limit < static_cast<int>(channel->getMemberFds().size())) {
+		if (!(iss >> limit) || limit < static_cast<int>(channel->getMemberCount())) {
 			return false;
 		}
 		channel->setLimitMembers(limit);
@@ -154,28 +154,33 @@ bool Server::handleModeB(char set, const std::string &parameter, Channel *channe
     return false;
 }
 
-void Server::processUserMode(int fd, const std::vector<std::string> &tokens) {
-	std::vector<std::string> params(tokens.begin() + 1, tokens.end());
-	if (Server::uncapitalizeString(params[0]) != clients[fd]->getNickname()) {
-		serverSendError(fd, params[0], ERR_USERSDONTMATCH);
+void Server::processUserMode(int fd, const Message &message) {
+	const std::string target = message.params[0].str();
+	if (Server::uncapitalizeString(target) != clients[fd]->getNickname()) {
+		serverSendError(fd, target, ERR_USERSDONTMATCH);
 		return;
 	}
-	std::vector<std::string>::const_iterator it = tokens.begin() + 2;
-    if (it == tokens.end()) {
+    if (message.paramCount == 1) {
         serverSendReply(fd, "", RPL_UMODEIS, clients[fd]->returnModes());
         return;
     }
-	for (; it != tokens.end(); ++it) {
-		Mode mode = clients[fd]->getMode(*it);
+	for (size_t i = 1; i < message.paramCount; ++i) {
+		const std::string modeString = message.params[i].str();
+		Mode mode = clients[fd]->getMode(modeString);
 		if (mode == UNKNOWN || mode == AWAY) {
-			serverSendError(fd, *it, ERR_UMODEUNKNOWNFLAG);
+			serverSendError(fd, modeString, ERR_UMODEUNKNOWNFLAG);
 			return;
-		} else if (it[0][0] == '+') {
+		} else if (modeString[0] == '+') {
 			clients[fd]->addMode(mode);
 			serverSendReply(fd, "", RPL_UMODEIS, clients[fd]->returnModes());
-		} else if (it[0][0] == '-') {
+		} else if (modeString[0] == '-') {
 			clients[fd]->removeMode(mode);
 			serverSendReply(fd, "", RPL_UMODEIS, clients[fd]->returnModes());
 		}
+		// the channels' visible names lists follow the client's +i
+		const std::vector<Channel *> &channels = clients[fd]->getChannels();
+		for (size_t j = 0; j < channels.size(); j++) {
+			channels[j]->setMemberInvisible(fd, clients[fd]->activeMode(INVISIBLE));
+		}
 	}
 }
\ No newline at end of file
@@ -1,79 +1,63 @@
 #include "../../headers/Server.hpp"
 
-void Server::processNames(int fd, const std::vector<std::string> &tokens) {
-	std::map<std::string, std::vector<std::string> > nicks;
-	if (tokens.size() == 1) {
-		nicks = getClientsOfChannels(fd, _channels);
-		std::pair<std::string, std::vector<std::string> > otherNicks = std::make_pair("*", getClientsWithoutChannels());
-		nicks.insert(otherNicks);
+void Server::processNames(int fd, const Message &message) {
+	if (message.paramCount == 0) {
+		for (ChannelMap::const_iterator it = _channels.begin(); it != _channels.end(); ++it) {
+			sendNames(fd, it->second);
+		}
+		sendNamesWithoutChannel(fd);
 	} else {
-		std::queue<std::string> channelNames = split(tokens[1], ',', true);
+		std::vector<std::string> channelNames;
+		split(message.params[0].str(), ',', true, channelNames);
 		if (channelNames.size() > MAXTARGETS) {
 			serverSendError(fd, "NAMES", ERR_TOOMANYTARGETS);
 			return;
 		}
 		std::vector<Channel *> channels = findChannels(channelNames);
-		nicks = getClientsOfChannels(fd, channels);
-	}
-	for (std::map<std::string, std::vector<std::string> >::iterator it = nicks.begin(); it != nicks.end(); ++it) {
-		std::string nicknamesString = mergeTokensToString(it->second, false);
-		if (!nicknamesString.empty()) {
-			serverSendReply(fd, (*it).first, RPL_NAMREPLY, nicknamesString);
+		for (std::vector<Channel *>::const_iterator it = channels.begin(); it != channels.end(); ++it) {
+			sendNames(fd, *it);
 		}
 	}
 	serverSendReply(fd, "", RPL_ENDOFNAMES, "");
 }
 
-std::map<std::string, std::vector<std::string> > Server::getClientsOfChannels(int fd, std::vector<Channel *> channels) {
-	std::map<std::string, std::vector<std::string> > nicks;
-	for (std::vector<Channel *>::iterator it = channels.begin(); it != channels.end(); ++it) {
-		std::vector<std::string> channelNicks;
-		Channel *channel = *it;
-		if (channel->hasMember(fd)) {
-			channelNicks = getAllChannelMembersNicks(channel);
-		} else {
-			channelNicks = getVisibleChannelMembersNicks(channel);
-		}
-		nicks.insert(std::make_pair(channel->getName(), channelNicks));
+// bytes of names that keep ":<server> 353 <nick> <token> :<names>\r\n" within
+// a protocol line, for a nickname up to NAMES_NICK_RESERVE
+size_t Server::namesLimit(const std::string &token) const {
+	size_t overhead = _replies[RPL_NAMREPLY].head.size() + NAMES_NICK_RESERVE + 1 + token.size()
+					  + _replies[RPL_NAMREPLY].text.size() + 4;
+	if (overhead + NAMES_CHUNK_MIN > MESSAGE_LINE_MAX) {
+		return NAMES_CHUNK_MIN;
 	}
-	return nicks;
+	return MESSAGE_LINE_MAX - overhead;
 }
 
-std::vector<std::string> Server::getAllChannelMembersNicks(const Channel *channel) {
-	std::vector<std::string> nicks;
-	std::set<int> members = channel->getMemberFds();
-	for (std::set<int>::iterator it = members.begin(); it != members.end(); ++it) {
-		std::string nick = clients[*it]->getNickname();
-		if (channel->hasOperator(*it)) {
-			nick = "@" + nick;
-		}
-		nicks.push_back(nick);
+// members see everyone, other clients only the members without +i
+void Server::sendNames(int fd, const Channel *channel) {
+	if (channel->hasMember(fd)) {
+		sendNamesChunks(fd, channel->getName(), channel->getNames());
+	} else {
+		sendNamesChunks(fd, channel->getName(), channel->getVisibleNames());
 	}
-	return nicks;
 }
 
-std::vector<std::string> Server::getVisibleChannelMembersNicks(const Channel *channel) {
-	std::vector<std::string> nicks;
-	std::set<int> members = channel->getMemberFds();
-	for (std::set<int>::iterator it = members.begin(); it != members.end(); ++it) {
-		if (!clients[*it]->activeMode(INVISIBLE)) {
-			std::string nick = clients[*it]->getNickname();
-			if (channel->hasOperator(*it)) {
-				nick = "@" + nick;
-			}
-			nicks.push_back(nick);
+void Server::sendNamesChunks(int fd, const std::string &token, const NamesList &names) {
+	const std::vector<std::string> &chunks = names.chunks();
+	for (std::vector<std::string>::const_iterator it = chunks.begin(); it != chunks.end(); ++it) {
+		if (!it->empty()) {
+			serverSendReply(fd, token, RPL_NAMREPLY, *it);
 		}
 	}
-	return nicks;
 }
 
-std::vector<std::string> Server::getClientsWithoutChannels() {
-	std::vector<std::string> nicks;
-	for (std::map<int, Client *>::iterator it = clients.begin(); it != clients.end(); ++it) {
-		Client *client = it->second;
-		if (!client->activeMode(INVISIBLE) && client->getChannels().empty()) {
-			nicks.push_back(client->getNickname());
+// visible registered clients outside of any channel, listed under "*"
+void Server::sendNamesWithoutChannel(int fd) {
+	NamesList names(namesLimit("*"));
+	for (std::vector<int>::const_iterator it = clients.fds().begin(); it != clients.fds().end(); ++it) {
+		Client *client = clients[*it];
+		if (client->isRegistered() && !client->activeMode(INVISIBLE) && client->getChannels().empty()) {
+			names.insert(client->getNickname());
 		}
 	}
-	return nicks;
-}
\ No newline at end of file
+	sendNamesChunks(fd, "*", names);
+}
@@ -1,21 +1,28 @@
 #include "../../headers/Server.hpp"
 
-void    Server::processNick(int fd, const std::vector<std::string> &tokens) {
-    if (tokens.size() < 2) {
+void    Server::processNick(int fd, const Message &message) {
+    if (message.paramCount < 1) {
         serverSendError(fd, clients[fd]->getNickname(), ERR_NONICKNAMEGIVEN);
         return;
     }
-    std::map<int, Client *>::iterator it = clients.begin();
-    for (; it != clients.end(); ++it) {
-        if (it->second != clients[fd] && it->second->getNickname() == Server::uncapitalizeString(tokens[1])) {
-            serverSendError(fd, clients[fd]->getNickname(), ERR_NICKNAMEINUSE);
-            return;
+    const std::string nickname = message.params[0].str();
+    if (!clients[fd]->isRegistered()) {
+        // collisions are checked once registration completes
+        if (!verifyNickname(fd, nickname)) {
+            clients[fd]->setNickname(nickname);
         }
+        return;
+    }
+    Client *holder = findClient(nickname);
+    if (holder && holder != clients[fd]) {
+        serverSendError(fd, clients[fd]->getNickname(), ERR_NICKNAMEINUSE);
+        return;
     }
-    if (verifyNickname(fd, tokens[1])) {
+    if (verifyNickname(fd, nickname)) {
         return;
-    } else {
-        clients[fd]->setNickname(tokens[1]);
-        serverSendReply(fd, "", RPL_WELCOME, clients[fd]->getNickname());
     }
+    // announced under the old prefix, to the client itself and its channel neighbours
+    const std::string prefix = getPrefix(fd);
+    renameClient(clients[fd], nickname);
+    serverSendNotification(channelNeighbours(clients[fd], true), prefix, "NICK", ":" + clients[fd]->getNickname());
 }
\ No newline at end of file
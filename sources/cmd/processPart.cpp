@@ -1,31 +1,29 @@
 #include "../../headers/Server.hpp"
 
-void Server::processPart(int fd, const std::vector<std::string> &tokens) {
-	if (tokens.size() < 2) {
+void Server::processPart(int fd, const Message &message) {
+	if (message.paramCount < 1) {
 		serverSendError(fd, "PART", ERR_NEEDMOREPARAMS);
 		return;
 	}
-	std::queue<std::string> channels = split(tokens[1], ',', true);
+	std::vector<std::string> channels;
+	split(message.params[0].str(), ',', true, channels);
 	if (channels.size() > MAXTARGETS) {
 		serverSendError(fd, "PART", ERR_TOOMANYTARGETS);
 		return;
 	}
 	std::string reason;
-	if (tokens.size() > 2) {
-		reason = tokens[2].at(0) == ':'
-				 ? mergeTokensToString(std::vector<std::string>(tokens.begin() + 2, tokens.end()), true)
-				 : tokens[2];
+	if (message.paramCount > 1) {
+		reason = message.params[1].str();
 	}
-	while (!channels.empty()) {
-		std::string channelName = channels.front();
-		channels.pop();
+	for (std::vector<std::string>::const_iterator it = channels.begin(); it != channels.end(); ++it) {
+		const std::string &channelName = *it;
 		Channel *channel = findChannel(channelName);
 		if (!channel) {
 			serverSendError(fd, channelName, ERR_NOSUCHCHANNEL);
 		} else if (!channel->hasMember(fd)) {
 			serverSendError(fd, channelName, ERR_NOTONCHANNEL);
 		} else {
-			serverSendNotification(channel->getMemberFds(), getNickAndHostname(fd), "PART", channelName + " :" + reason);
+			serverSendNotification(channel, getPrefix(fd), "PART", channelName + " :" + reason);
 			removeClientFromChannel(fd, channel);
 		}
 	}
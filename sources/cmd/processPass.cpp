@@ -0,0 +1,13 @@
+#include "../../headers/Server.hpp"
+
+void Server::processPass(int fd, const Message &message) {
+	if (message.paramCount < 1) {
+		serverSendError(fd, "PASS", ERR_NEEDMOREPARAMS);
+		clients[fd]->setQuit(true);
+		return;
+	}
+	const std::string password = message.params[0].str();
+	if (verifyPassword(fd, password)) {
+		clients[fd]->setQuit(true);
+	}
+}
\ No newline at end of file
@@ -1,12 +1,19 @@
 #include "../../headers/Server.hpp"
 
-void Server::processPing(int fd, const std::vector<std::string> &tokens) {
-	if (tokens.size() <= 1) {
+void Server::processPing(int fd, const Message &message) {
+	if (!message.paramCount) {
 		serverSendError(fd, "", ERR_NOORIGIN);
-	} else if (tokens[1] != serverName) {
+	} else if (message.params[0] != serverName.c_str()) {
 		serverSendError(fd, "", ERR_NOSUCHSERVER);
 	} else {
 		std::string pong = ":42.IRC PONG 42.IRC :42.IRC\r\n";
         serverSendMessage(fd, pong);
 	}
+}
+
+void Server::processPong(int fd, const Message &message) {
+	// answer to a keepalive PING: receiving it already refreshed the client activity
+	if (!message.paramCount) {
+		serverSendError(fd, "", ERR_NOORIGIN);
+	}
 }
\ No newline at end of file
@@ -1,8 +1,12 @@
 #include "../../headers/Server.hpp"
 
-bool Server::checkPmTokens(int fd, const std::vector<std::string> &tokens) {
-	if (tokens.size() == 1 || tokens.size() == 2) {
-		serverSendError(fd, "", (tokens.size() == 1) ? ERR_NORECIPIENT : ERR_NOTEXTTOSEND);
+bool Server::checkPmTokens(int fd, const Message &message) {
+	if (message.paramCount < 1 || message.params[0].empty()) {
+		serverSendError(fd, "", ERR_NORECIPIENT);
+		return false;
+	}
+	if (message.paramCount < 2 || message.params[1].empty()) {
+		serverSendError(fd, "", ERR_NOTEXTTOSEND);
 		return false;
 	}
 	return true;
@@ -30,9 +34,7 @@ void Server::sendPmToChan(int fd, const std::string &message, const std::string
 	if (channel) {
 		if (channel->hasMember(fd)) {
 			std::string parameters = channel->getName() + " :" + message;
-			std::set<int> receiversFds(channel->getMemberFds());
-			receiversFds.erase(fd);
-			serverSendNotification(receiversFds, prefix, command, parameters);
+			serverSendNotification(channel, prefix, command, parameters, fd);
 		} else if (command == "PRIVMSG") {
 			serverSendError(fd, targetName, ERR_CANNOTSENDTOCHAN);
 		}
@@ -41,27 +43,29 @@ void Server::sendPmToChan(int fd, const std::string &message, const std::string
 	}
 }
 
-void Server::processPrivmsg(int fd, const std::vector<std::string> &tokens) {
-	if (!checkPmTokens(fd, tokens))
+void Server::processPrivmsg(int fd, const Message &message) {
+	if (!checkPmTokens(fd, message))
 		return;
 
-	std::queue<std::string> targets = split(tokens[1], ',', true);
+	const std::string command = message.command.str();
+	std::vector<std::string> targets;
+	split(message.params[0].str(), ',', true, targets);
 	if (targets.size() > MAXTARGETS) {
-		serverSendError(fd, tokens[0], ERR_TOOMANYTARGETS);
+		serverSendError(fd, command, ERR_TOOMANYTARGETS);
 		return;
 	}
 
-	std::string message = tokens[2].at(0) == ':'
-						  ? mergeTokensToString(std::vector<std::string>(tokens.begin() + 2, tokens.end()), true)
-						  : tokens[2];
-	std::string prefix = getNickAndHostname(fd);
-	while (!targets.empty()) {
-		const std::string targetName = targets.front();
-		targets.pop();
+	std::string text = message.params[1].str();
+	const std::string &prefix = getPrefix(fd);
+	for (std::vector<std::string>::const_iterator it = targets.begin(); it != targets.end(); ++it) {
+		const std::string &targetName = *it;
+		if (targetName.empty()) {
+			continue;
+		}
 		if (targetName.at(0) == '#' || targetName.at(0) == '&') {
-			sendPmToChan(fd, message, prefix, targetName, tokens[0]);
+			sendPmToChan(fd, text, prefix, targetName, command);
 		} else {
-			sendPmToUser(fd, message, prefix, targetName, tokens[0]);
+			sendPmToUser(fd, text, prefix, targetName, command);
 		}
 	}
 }
\ No newline at end of file
@@ -1,16 +1,16 @@
 #include "../../headers/Server.hpp"
 
-void Server::processTopic(int fd, const std::vector<std::string> &tokens) {
-	if (tokens.size() < 2) {
+void Server::processTopic(int fd, const Message &message) {
+	if (message.paramCount < 1) {
 		serverSendError(fd, "TOPIC", ERR_NEEDMOREPARAMS);
 		return;
 	}
 
-	const std::string &channelName = tokens[1];
+	const std::string channelName = message.params[0].str();
 	Channel *channel = findChannel(channelName);
 	if (!channel) {
 		serverSendError(fd, channelName, ERR_NOSUCHCHANNEL);
-	} else if (tokens.size() == 2) {
+	} else if (message.paramCount == 1) {
 		std::string topic = channel->getTopic();
 		if (topic.empty()) {
 			serverSendReply(fd, channelName, RPL_NOTOPIC, "");
@@ -23,11 +23,9 @@ void Server::processTopic(int fd, const std::vector<std::string> &tokens) {
 		} else if (channel->isModeSet(TOPICSET) && !channel->hasOperator(fd)) {
 			serverSendError(fd, channelName, ERR_CHANOPRIVSNEEDED);
 		} else {
-			std::string topic = tokens[2].at(0) == ':'
-								? mergeTokensToString(std::vector<std::string>(tokens.begin() + 2, tokens.end()), true)
-								: tokens[2];
+			std::string topic = message.params[1].str();
 			channel->setTopic(topic);
-			serverSendNotification(channel->getMemberFds(), getNickAndHostname(fd), "TOPIC", channelName + " :" + topic);
+			serverSendNotification(channel, getPrefix(fd), "TOPIC", channelName + " :" + topic);
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,23 @@
+#include "../../headers/Server.hpp"
+
+void Server::processUser(int fd, const Message &message) {
+	if (message.paramCount < 3) {
+		serverSendError(fd, "USER", ERR_NEEDMOREPARAMS);
+		return;
+	}
+	clients[fd]->setUsername(message.params[0].str());
+	// USER <user> <mode> <unused> :<realname>, the unused field is sometimes left out
+	std::string realname = message.params[message.paramCount - 1].str();
+	if (verifyUsername(fd, realname)) {
+		return;
+	}
+	clients[fd]->setRealName(realname);
+	std::string mode = message.params[1].str();
+	if (isBitMask(mode)) {
+		Mode bitMode = getBitMode(mode);
+		if (bitMode == UNKNOWN)
+			serverSendError(fd, mode, ERR_UMODEUNKNOWNFLAG);
+		else
+			clients[fd]->addMode(bitMode);
+	}
+}
\ No newline at end of file
@@ -1,36 +1,191 @@
 #include "../../headers/Server.hpp"
 
-void Server::processWho(int fd, const std::vector<std::string> &tokens) {
-	if (tokens.size() < 2) {
-		serverSendError(fd, "WHO", ERR_NEEDMOREPARAMS);
-		return;
+void Server::processWho(int fd, const Message &message) {
+	WhoQuery query;
+	query.parse(message.paramCount > 0 ? message.params[0].str() : "",
+				message.paramCount > 1 ? message.params[1].str() : "");
+	startWho(fd, query);
+}
+
+// the first page is queued right away, a new WHO replaces one in progress
+void Server::startWho(int fd, const WhoQuery &query) {
+	for (std::vector<WhoPager>::iterator it = _whoPagers.begin(); it != _whoPagers.end(); ++it) {
+		if (it->client.fd == fd) {
+			_whoPagers.erase(it);
+			break;
+		}
 	}
-	std::string targetName = tokens[1];
-	std::vector<std::pair<std::string, std::string> > info;
-	if (targetName.at(0) == '#' || targetName.at(0) == '&') {
-		Channel *channel = findChannel(targetName);
+	WhoPager pager;
+	pager.client = clients.handle(fd);
+	pager.query = query;
+	pager.position = 0;
+	if (!query.target.empty() && (query.target[0] == '#' || query.target[0] == '&')) {
+		pager.source = WHO_CHANNEL;
+		pager.channel = uncapitalizeString(query.target);
+		// the member array is reordered by parts, so pages walk a snapshot of who was there
+		Channel *channel = findFoldedChannel(pager.channel);
 		if (channel) {
-			std::set<int> members = channel->getMemberFds();
-			for (std::set<int>::iterator it = members.begin(); it != members.end(); ++it) {
-				Client *client = clients[*it];
-				if (!client->activeMode(INVISIBLE) || channel->hasMember(fd)) {
-					info.push_back(takeFullClientInfo(client, channel));
+			const std::vector<Member> &members = channel->getMembers();
+			pager.members.reserve(channel->getMemberCount());
+			for (std::vector<Member>::const_iterator it = members.begin(); it != members.end(); ++it) {
+				if (it->flags & MEMBER_JOINED) {
+					pager.members.push_back(clients.handle(it->fd));
 				}
 			}
 		}
+	} else if (query.match == WHO_MATCH_HOST) {
+		pager.source = WHO_HOSTS;
 	} else {
-		Client *client = findClient(targetName);
-		if (client) {
-			info.push_back(takeFullClientInfo(client, NULL));
+		pager.source = WHO_NICKS;
+	}
+	if (whoNextPage(pager)) {
+		_whoPagers.push_back(pager);
+	}
+}
+
+// queues up to WHO_PAGE_SIZE replies after the cursor, false once RPL_ENDOFWHO went out
+bool Server::whoNextPage(WhoPager &pager) {
+	const WhoQuery &query = pager.query;
+	int fd = pager.client.fd;
+	bool more = false;
+	size_t sent = 0;
+	size_t scanned = 0;
+	if (query.operatorsOnly) {
+		// no server operators
+	} else if (pager.source == WHO_CHANNEL) {
+		Channel *channel = findFoldedChannel(pager.channel);
+		if (channel) {
+			bool joined = channel->hasMember(fd);
+			for (; pager.position < pager.members.size(); pager.position++) {
+				if (sent == WHO_PAGE_SIZE || scanned++ == WHO_SCAN_LIMIT) {
+					more = true;
+					break;
+				}
+				// members who left since the snapshot are skipped
+				Client *client = clients.find(pager.members[pager.position]);
+				if (client && channel->hasMember(client->getSocket())
+					&& (joined || !client->activeMode(INVISIBLE))) {
+					sendWhoReply(fd, query, client, channel);
+					sent++;
+				}
+			}
+		}
+	} else if (pager.source == WHO_NICKS) {
+		// a nickname-only match starts at the mask prefix, anything else walks every nickname
+		const std::string &prefix = query.match == WHO_MATCH_NICK ? query.mask.prefix() : "";
+		std::map<std::string, Client *>::const_iterator it
+			= !pager.cursor.first.empty() ? _nicknames.upper_bound(pager.cursor.first)
+										  : _nicknames.lower_bound(prefix);
+		for (; it != _nicknames.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+			if (sent == WHO_PAGE_SIZE || scanned++ == WHO_SCAN_LIMIT) {
+				more = true;
+				break;
+			}
+			pager.cursor.first = it->first;
+			if (whoMatches(query, it->second) && visibleTo(it->second, fd, query)) {
+				sendWhoReply(fd, query, it->second, NULL);
+				sent++;
+			}
+		}
+	} else {
+		const std::string &prefix = query.mask.prefix();
+		std::set<std::pair<std::string, std::string> >::const_iterator it
+			= !pager.cursor.first.empty() ? _hosts.upper_bound(pager.cursor)
+										  : _hosts.lower_bound(std::make_pair(prefix, std::string()));
+		for (; it != _hosts.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+			if (sent == WHO_PAGE_SIZE || scanned++ == WHO_SCAN_LIMIT) {
+				more = true;
+				break;
+			}
+			pager.cursor = *it;
+			Client *client = findClient(it->second);
+			if (client && whoMatches(query, client) && visibleTo(client, fd, query)) {
+				sendWhoReply(fd, query, client, NULL);
+				sent++;
+			}
 		}
 	}
-	for (std::vector<std::pair<std::string, std::string> >::iterator it = info.begin(); it != info.end(); ++it) {
-		serverSendReply(fd, it->first, RPL_WHOREPLY, it->second);
+	if (!more) {
+		serverSendReply(fd, query.target.empty() ? "*" : query.target, RPL_ENDOFWHO, "");
 	}
-	serverSendReply(fd, targetName, RPL_ENDOFWHO, "");
+	return more;
 }
 
-std::pair<std::string, std::string> Server::takeFullClientInfo(Client *client, Channel *channel) {
+bool Server::whoMatches(const WhoQuery &query, Client *client) {
+	const Mask &mask = query.mask;
+	if (mask.matchesAll()) {
+		return true;
+	}
+	return ((query.match & WHO_MATCH_NICK) && mask.match(client->getNickname()))
+		   || ((query.match & WHO_MATCH_USER) && mask.match(client->getUsername()))
+		   || ((query.match & WHO_MATCH_HOST) && mask.match(client->getHostname()))
+		   || ((query.match & WHO_MATCH_SERVER) && mask.match(serverName))
+		   || ((query.match & WHO_MATCH_REALNAME) && mask.match(client->getRealName()));
+}
+
+// invisible clients are only listed to their channel neighbours, or when
+// their exact nickname is asked for
+bool Server::visibleTo(Client *client, int fd, const WhoQuery &query) {
+	if (client->getSocket() == fd || !client->activeMode(INVISIBLE)) {
+		return true;
+	}
+	if (query.mask.exact() && query.mask.match(client->getNickname())) {
+		return true;
+	}
+	const std::vector<Channel *> &channels = client->getChannels();
+	for (std::vector<Channel *>::const_iterator it = channels.begin(); it != channels.end(); ++it) {
+		if ((*it)->hasMember(fd)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// RPL_WHOREPLY, or RPL_WHOSPCRPL with the requested fields in WHOX_FIELDS order
+void Server::sendWhoReply(int fd, const WhoQuery &query, Client *client, const Channel *channel) {
+	if (query.fields.empty()) {
+		std::pair<std::string, std::string> info = takeFullClientInfo(client, channel);
+		serverSendReply(fd, info.first, RPL_WHOREPLY, info.second);
+		return;
+	}
+	std::string reply;
+	std::string realName;
+	char number[24];
+	for (size_t i = 0; i < query.fields.size(); i++) {
+		if (query.fields[i] == 'r') {
+			realName = client->getRealName();
+			continue;
+		}
+		if (!reply.empty()) {
+			reply += ' ';
+		}
+		switch (query.fields[i]) {
+			case 't': reply += query.token.empty() ? "0" : query.token; break;
+			case 'c': reply += channel ? channel->getName() : "*"; break;
+			case 'u': reply.append("~").append(client->getUsername()); break;
+			case 'i':
+			case 'h': reply += client->getHostname(); break;
+			case 's': reply += serverName; break;
+			case 'n': reply += client->getNickname(); break;
+			case 'f':
+				reply += client->activeMode(AWAY) ? "G" : "H";
+				if (channel && channel->hasOperator(client->getSocket())) {
+					reply += '@';
+				}
+				break;
+			case 'd': reply += '0'; break;
+			case 'l':
+				snprintf(number, sizeof(number), "%lu", (_now - client->getLastActivity()) / 1000);
+				reply += number;
+				break;
+			case 'a': reply += '0'; break;
+			case 'o': reply += "n/a"; break;
+		}
+	}
+	serverSendReply(fd, reply, RPL_WHOSPCRPL, realName);
+}
+
+std::pair<std::string, std::string> Server::takeFullClientInfo(Client *client, const Channel *channel) {
 	std::string clientInfo;
 	clientInfo
 		.append(channel ? channel->getName() : "*")
@@ -44,7 +199,46 @@ std::pair<std::string, std::string> Server::takeFullClientInfo(Client *client, C
 	return std::make_pair(clientInfo, hopcountAndRealName);
 }
 
-void    Server::processWhois(int fd, const std::vector<std::string> &tokens) {
-    (void)tokens;
-    serverSendReply(fd, "", RPL_ENDOFWHOIS, "");
-}
\ No newline at end of file
+// WHOIS [<server>] <nick>{,<nick>}
+void Server::processWhois(int fd, const Message &message) {
+	if (message.paramCount < 1) {
+		serverSendError(fd, "", ERR_NONICKNAMEGIVEN);
+		return;
+	}
+	const std::string targets = message.params[message.paramCount > 1 ? 1 : 0].str();
+	std::vector<std::string> nicknames;
+	split(targets, ',', true, nicknames);
+	if (nicknames.size() > MAXTARGETS) {
+		serverSendError(fd, "WHOIS", ERR_TOOMANYTARGETS);
+		return;
+	}
+	for (std::vector<std::string>::const_iterator it = nicknames.begin(); it != nicknames.end(); ++it) {
+		Client *client = findClient(*it);
+		if (!client) {
+			serverSendError(fd, *it, ERR_NOSUCHNICK);
+			continue;
+		}
+		const std::string &nick = client->getNickname();
+		serverSendReply(fd, nick + " ~" + client->getUsername() + " " + client->getHostname() + " *",
+						RPL_WHOISUSER, client->getRealName());
+		const std::vector<Channel *> &channels = client->getChannels();
+		std::string names;
+		for (std::vector<Channel *>::const_iterator it = channels.begin(); it != channels.end(); ++it) {
+			if (!names.empty()) {
+				names += ' ';
+			}
+			if ((*it)->hasOperator(client->getSocket())) {
+				names += '@';
+			}
+			names += (*it)->getName();
+		}
+		if (!names.empty()) {
+			serverSendReply(fd, nick, RPL_WHOISCHANNELS, names);
+		}
+		serverSendReply(fd, nick + " " + serverName, RPL_WHOISSERVER, "");
+		if (client->activeMode(AWAY)) {
+			serverSendReply(fd, nick, RPL_AWAY, client->getAwayMessage());
+		}
+	}
+	serverSendReply(fd, targets, RPL_ENDOFWHOIS, "");
+}
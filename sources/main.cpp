@@ -11,12 +11,22 @@ void signalHandler(int signum) {
 int main(int argc, char **argv) {
 	if (argc < 3) {
 		std::cerr << "ERROR! Usage: " << argv[0] << " <port> <_password>"
+				  << " [--backend=poll|epoll|epoll-et|io_uring] [--register-timeout=s]"
+				  << " [--ping-interval=s] [--ping-timeout=s] [--accept-batch=n]"
+				  << " [--max-clients=n] [--cpu=n]"
 				  << std::endl;
 		return 1;
 	}
 	try {
-		Server server (atoi(argv[1]), std::string(argv[2]));
+		Config config;
+		for (int i = 3; i < argc; i++) {
+			config.parseOption(argv[i]);
+		}
+		config.applyCpuAffinity();
+		Server server (atoi(argv[1]), std::string(argv[2]), config);
 		signal(SIGINT, signalHandler);
+		// a peer closing its end is handled through the writev error
+		signal(SIGPIPE, SIG_IGN);
 		while (running) {
 			try {
 				server.run();
@@ -2,119 +2,69 @@
 
 // Parsing
 
-bool Server::parsBuffer(int fd) {
-	std::string bufferStr(this->_buffer);
-	std::stringstream ss(bufferStr);
-	std::string line;
-
-//	 add recvBuffer at the beginning of ss if not empty
-	try {
-		Client &client = getClient(fd);
-		if (!client.isRecvBufferEmpty()) {
-			ss.str("");
-			ss << client.getRecvBuffer() << bufferStr;
-			client.resetRecvBuffer();
-		}
-		// check if buffer contains a full line
-		size_t cRet = ss.str().find('\n');
-		if (cRet == std::string::npos) {
-			// if not, add buffer to recvBuffer and return
-			client.appendRecvBuffer(ss.str());
-			return false;
-		}
-	}
-	catch (std::exception &e) {
-		std::cerr << e.what() << std::endl;
+bool Server::parsLine(int fd, const char *line, size_t length) {
+	Message message;
+	if (!message.parse(line, length)) {
+		return false;
 	}
-//	 tokenize the buffer line by line
-	while (std::getline(ss, line)) {
-		size_t cRet = line.find('\r');
-		if (cRet != std::string::npos)
-			line.erase(cRet);
-
-		std::istringstream lineStream(line);
-		std::vector<std::string> tokens;
-		std::string token;
-		while (lineStream >> token) {
-			tokens.push_back(token);
+	Client *client = clients[fd];
+	bool registered = client->isRegistered();
+	const Command *command = findCommand(message.command);
+	if (!command) {
+		if (registered) {
+			serverSendError(fd, message.command.str(), ERR_UNKNOWNCOMMAND);
 		}
-		if (!clients[fd]->isRegistered()) {
-			if (registrationProcess(fd, tokens))
-				return true;
-		} else
-			processCmd(fd, tokens);
+		return false;
 	}
-	return false;
-}
-
-bool Server::registrationProcess(int fd, std::vector<std::string> &tokens) {
-	if (tokens.empty())
-		return false; // or 1?
-	std::string command = tokens[0];
-	std::vector<std::string> params(tokens.begin() + 1, tokens.end());
-	if (command == "CAP") {
-		if (tokens[1] == "LS") {
-			serverSendReply(fd, "", CAPLS, "");
+	if (!(command->states & (registered ? CMD_REGISTERED : CMD_UNREGISTERED))) {
+		// registration commands are refused afterwards, the rest is ignored until then
+		if (registered) {
+			serverSendError(fd, "", ERR_ALREADYREGISTERED);
 		}
-	} else if (handleCommand(fd, command, params)) {
-		return true;
+		return false;
 	}
-	return checkRegistration(fd);
-}
-
-bool Server::handleCommand(int fd, const std::string &command, const std::vector<std::string> &params) {
-	if (command == "PASS") {
-		if (params.empty()) {
-			return (serverSendError(fd, "PASS", ERR_NEEDMOREPARAMS), 1);
-		}
-		if (verifyPassword(fd, params[0]))
-			return true;
-		else
-			clients[fd]->setPassword(params[0]);
-	} else if (command == "NICK") {
-		if (params.empty()) {
-			return (serverSendError(fd, "NICK", ERR_NEEDMOREPARAMS), 0);
-		}
-		if (verifyNickname(fd, params[0]))
-			return false;
-		else
-			clients[fd]->setNickname(params[0]);
-	} else if (command == "USER") {
-		if (params.size() < 3) {
-			serverSendError(fd, "USER", ERR_NEEDMOREPARAMS);
-			return false;
-		}
-		clients[fd]->setUsername(params[0]);
-		std::string realname = params[2].at(0) == ':'
-							   ? mergeTokensToString(std::vector<std::string>(params.begin() + 2, params.end()), true)
-							   : params[2];
-		if (verifyUsername(fd, realname))
-			return false;
-		else {
-			clients[fd]->setRealName(realname);
-		}
-		if (isBitMask(params[1])) {
-			Mode mode = getBitMode(params[1]);
-			if (mode == UNKNOWN)
-				serverSendError(fd, params[1], ERR_UMODEUNKNOWNFLAG);
-			else
-				clients[fd]->addMode(mode);
-		}
+	(this->*(command->handler))(fd, message);
+	if (!registered && !client->isQuit()) {
+		return checkRegistration(fd);
 	}
 	return false;
 }
 
-void Server::processCmd(int fd, std::vector<std::string> &tokens) {
-	if (tokens.empty() || tokens[0] == "CAP")
-		return;
-
-	std::string command = tokens[0];
-	CmdIterator it = cmd.find(command);
-	if (it != cmd.end()) {
-		(this->*(it->second))(fd, tokens);
-	} else {
-		serverSendError(fd, command, ERR_UNKNOWNCOMMAND);
+// a switch on the first letter, and on the length or second letter where
+// names collide, picks the only candidate, one compare confirms it
+const Server::Command *Server::findCommand(const Slice &name) {
+	int id = -1;
+	switch (name.first()) {
+		case 'A': id = CMD_AWAY; break;
+		case 'C': id = CMD_CAP; break;
+		case 'I': id = CMD_INVITE; break;
+		case 'J': id = CMD_JOIN; break;
+		case 'K': id = CMD_KICK; break;
+		case 'L': id = CMD_LIST; break;
+		case 'M': id = CMD_MODE; break;
+		case 'N':
+			id = name.length == 4 ? CMD_NICK : name.length == 5 ? CMD_NAMES : CMD_NOTICE;
+			break;
+		case 'P':
+			if (name.length == 7) {
+				id = CMD_PRIVMSG;
+			} else if (name.length == 4) {
+				switch (name.data[1]) {
+					case 'I': id = CMD_PING; break;
+					case 'O': id = CMD_PONG; break;
+					case 'A': id = name.data[2] == 'S' ? CMD_PASS : CMD_PART; break;
+				}
+			}
+			break;
+		case 'Q': id = CMD_QUIT; break;
+		case 'T': id = CMD_TOPIC; break;
+		case 'U': id = CMD_USER; break;
+		case 'W': id = name.length == 3 ? CMD_WHO : CMD_WHOIS; break;
+	}
+	if (id < 0 || name != commands[id].name) {
+		return NULL;
 	}
+	return &commands[id];
 }
 
 // Registration utils
@@ -122,26 +72,17 @@ void Server::processCmd(int fd, std::vector<std::string> &tokens) {
 bool Server::checkRegistration(int fd) {
 	// check if logging is complete
 	if (clients[fd]->isLogged() && (!clients[fd]->getNickname().empty() && !clients[fd]->getUsername().empty())) {
-		// check if user (nickname) is in database
-		if (users.find(clients[fd]->getNickname()) != users.end()) {
-            // check if user is already connected
-            std::map<int, Client *>::iterator it = clients.begin();
-            for (; it != clients.end(); ++it) {
-                if (it->second != clients[fd] && it->second->getNickname() == clients[fd]->getNickname()) {
-                    serverSendError(fd, clients[fd]->getNickname(), ERR_NICKNAMEINUSE);
-                    return true;
-                }
-            }
-		} else {
-			// if first time user connect: add to database
-			users.insert(std::make_pair(clients[fd]->getNickname(), clients[fd]->getPassword()));
+		// check if the nickname is held by a connected user
+		if (_nicknames.find(clients[fd]->getNickname()) != _nicknames.end()) {
+			serverSendError(fd, clients[fd]->getNickname(), ERR_NICKNAMEINUSE);
+			return true;
 		}
+		_nicknames[clients[fd]->getNickname()] = clients[fd];
+		indexHost(clients[fd], true);
 		// registration complete, send welcome
 		clients[fd]->setRegistration();
-		serverSendReply(fd, "", RPL_WELCOME, clients[fd]->getNickname());
-		serverSendReply(fd, "", RPL_YOURHOST, "");
-		serverSendReply(fd, "", RPL_CREATED, "");
-		serverSendReply(fd, "", RPL_MYINFO, "");
+		startTimer(clients[fd], TIMER_IDLE, _config.pingInterval * 1000);
+		sendRegistrationBurst(fd);
 	}
 	return false;
 }
@@ -155,6 +96,8 @@ bool Server::verifyUsername(int fd, const std::string &arg) {
 }
 
 bool Server::verifyNickname(int fd, const std::string &arg) {
+	if (arg.empty())
+		return (serverSendError(fd, "", ERR_NONICKNAMEGIVEN), 1);
 	if (arg[0] == ':' || arg[0] == '$')
 		return (serverSendError(fd, arg, ERR_ERRONEUSNICKNAME), 1);
 	std::string ill = " ,*?!@.";
@@ -184,65 +127,140 @@ void Server::serverSendError(int fd, const std::string &token, serverRep id) {
 		serverSendMessage(fd, "ERROR :Closing connection :" + token + "\r\n");
 		return;
 	}
-	std::stringstream fullReply;
-    fullReply << ":" << serverName << " " << paddDigits(id) << " " << getNick(fd);
-	if (!token.empty()) {
-		fullReply << " " << token;
-	}
-	fullReply << _serverMessages[id] << "\r\n";
-	serverSendMessage(fd, fullReply.str());
+	serverSendMessage(fd, formatReply(fd, id, token, ""));
 }
 
 void Server::serverSendReply(int fd, const std::string &token, serverRep id, const std::string &reply) {
-	std::stringstream fullReply;
 	if (id == CAPLS) {
-        fullReply << "CAP * LS :" << "\r\n";
-		serverSendMessage(fd, fullReply.str());
+		serverSendMessage(fd, _capLs);
 		return;
 	}
-    fullReply << ":" << serverName << " " << paddDigits(id) << " " << getNick(fd);
+	serverSendMessage(fd, formatReply(fd, id, token, reply));
+}
+
+static char *appendBytes(char *out, const std::string &bytes) {
+	memcpy(out, bytes.data(), bytes.size());
+	return out + bytes.size();
+}
+
+// ":<server> <code> <nick>[ <token>]<text>[ :<reply>]\r\n", sized first and
+// written straight into the payload that gets queued
+PayloadRef Server::formatReply(int fd, serverRep id, const std::string &token, const std::string &reply) {
+	static const std::string noNick;
+	const ReplyTemplate &format = _replies[id];
+	Client *client = findClient(fd);
+	const std::string &nick = client ? client->getNickname() : noNick;
+
+	size_t length = format.head.size() + nick.size() + format.text.size() + 2;
 	if (!token.empty()) {
-		fullReply << " " << token;
+		length += 1 + token.size();
 	}
-	if (_serverMessages.find(id) != _serverMessages.end()) {
-		fullReply << _serverMessages[id];
+	if (!reply.empty()) {
+		length += 2 + reply.size();
 	}
+	Payload *payload = Payload::create(length);
+	char *out = appendBytes(payload->data(), format.head);
+	out = appendBytes(out, nick);
+	if (!token.empty()) {
+		*out++ = ' ';
+		out = appendBytes(out, token);
+	}
+	out = appendBytes(out, format.text);
 	if (!reply.empty()) {
-		fullReply << " :" << reply;
+		*out++ = ' ';
+		*out++ = ':';
+		out = appendBytes(out, reply);
+	}
+	*out++ = '\r';
+	*out = '\n';
+	return PayloadRef(payload);
+}
+
+// RPL_WELCOME to RPL_MYINFO in a single payload, only the nickname varies
+void Server::sendRegistrationBurst(int fd) {
+	static const serverRep burst[] = {RPL_WELCOME, RPL_YOURHOST, RPL_CREATED, RPL_MYINFO};
+	const std::string &nick = clients[fd]->getNickname();
+	size_t length = 0;
+	for (size_t i = 0; i < sizeof(burst) / sizeof(burst[0]); i++) {
+		length += _replies[burst[i]].head.size() + nick.size() + _replies[burst[i]].text.size() + 2;
+	}
+	// the welcome line ends with " :<nick>"
+	length += 2 + nick.size();
+	Payload *payload = Payload::create(length);
+	char *out = payload->data();
+	for (size_t i = 0; i < sizeof(burst) / sizeof(burst[0]); i++) {
+		out = appendBytes(out, _replies[burst[i]].head);
+		out = appendBytes(out, nick);
+		out = appendBytes(out, _replies[burst[i]].text);
+		if (burst[i] == RPL_WELCOME) {
+			*out++ = ' ';
+			*out++ = ':';
+			out = appendBytes(out, nick);
+		}
+		*out++ = '\r';
+		*out++ = '\n';
 	}
-	fullReply << "\r\n";
-	serverSendMessage(fd, fullReply.str());
+	serverSendMessage(fd, PayloadRef(payload));
+}
+
+// ":<prefix> <command> <parameters>\r\n" written straight into a payload
+PayloadRef Server::formatNotification(const std::string &prefix, const std::string &command,
+									  const std::string &parameters) {
+	Payload *payload = Payload::create(prefix.size() + command.size() + parameters.size() + 5);
+	char *out = payload->data();
+	*out++ = ':';
+	out = appendBytes(out, prefix);
+	*out++ = ' ';
+	out = appendBytes(out, command);
+	*out++ = ' ';
+	out = appendBytes(out, parameters);
+	*out++ = '\r';
+	*out = '\n';
+	return PayloadRef(payload);
 }
 
 void Server::serverSendNotification(int fd, const std::string &prefix, const std::string &command,
 									const std::string &parameters) {
-	std::stringstream fullNotification;
-	fullNotification << ":" << prefix << " " << command << " " << parameters << "\r\n";
-	serverSendMessage(fd, fullNotification.str());
+	serverSendMessage(fd, formatNotification(prefix, command, parameters));
 }
 
-void Server::serverSendNotification(const std::set<int> &fds, const std::string &prefix, const std::string &command,
+void Server::serverSendNotification(const std::vector<int> &fds, const std::string &prefix, const std::string &command,
 									const std::string &parameters) {
-	std::stringstream fullNotification;
-	fullNotification << ":" << prefix << " " << command << " " << parameters << "\r\n";
-	std::string notificationStr = fullNotification.str();
+	// formatted once, every recipient queues a reference to the same bytes
+	PayloadRef notification = formatNotification(prefix, command, parameters);
 
-	for (std::set<int>::const_iterator it = fds.begin(); it != fds.end(); ++it) {
-		serverSendMessage(*it, notificationStr);
+	for (std::vector<int>::const_iterator it = fds.begin(); it != fds.end(); ++it) {
+		serverSendMessage(*it, notification);
 	}
 }
 
-void Server::serverSendMessage(int fd, const std::string &message) {
-	try {
-		getClient(fd).pushSendQueue(message);
-	} catch (std::exception &e) {
-		std::cout << "[ERR] " << e.what() << std::endl;
+// reaches the joined members of a channel, except one when exceptFd is set
+void Server::serverSendNotification(const Channel *channel, const std::string &prefix, const std::string &command,
+									const std::string &parameters, int exceptFd) {
+	PayloadRef notification = formatNotification(prefix, command, parameters);
+
+	const std::vector<Member> &members = channel->getMembers();
+	for (std::vector<Member>::const_iterator it = members.begin(); it != members.end(); ++it) {
+		if ((it->flags & MEMBER_JOINED) && it->fd != exceptFd) {
+			serverSendMessage(it->fd, notification);
+		}
 	}
 }
 
-std::string Server::paddDigits(int i) {
-	std::ostringstream stream;
-	stream << std::setw(3) << std::setfill('0') << i;
-	return stream.str();
+void Server::serverSendMessage(int fd, const std::string &message) {
+	serverSendMessage(fd, PayloadRef(message));
+}
+
+void Server::serverSendMessage(int fd, const PayloadRef &message) {
+	Client *client = findClient(fd);
+	if (!client) {
+		return;
+	}
+	client->pushSendQueue(message);
+	if (!client->isPendingWrite()) {
+		client->setPendingWrite(true);
+		_writers.push_back(fd);
+	}
 }
 
+
@@ -8,25 +8,23 @@
 	return output;
 }
 
-std::queue<std::string> Server::split(const std::string &src, char delimiter, bool unique) {
-	std::set<std::string> uniqueTokens;
-	std::queue<std::string> tokensQueue;
-	std::istringstream srcStream(src);
-	std::string token;
-
-	while (std::getline(srcStream, token, delimiter)) {
-		if (unique) {
-			uniqueTokens.insert(token);
-		} else {
-			tokensQueue.push(token);
+// fills tokens in place, a trailing delimiter adds no empty token; unique
+// tokens come back sorted
+void Server::split(const std::string &src, char delimiter, bool unique, std::vector<std::string> &tokens) {
+	tokens.clear();
+	size_t start = 0;
+	while (start < src.size()) {
+		size_t end = src.find(delimiter, start);
+		if (end == std::string::npos) {
+			end = src.size();
 		}
+		tokens.push_back(src.substr(start, end - start));
+		start = end + 1;
 	}
 	if (unique) {
-		for (std::set<std::string>::const_iterator it = uniqueTokens.begin(); it != uniqueTokens.end(); ++it) {
-			tokensQueue.push(*it);
-		}
+		std::sort(tokens.begin(), tokens.end());
+		tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
 	}
-	return tokensQueue;
 }
 
 bool Server::isValidName(const std::string &name) {
@@ -41,7 +39,7 @@ bool Server::isValidName(const std::string &name) {
 	return true;
 }
 
-std::string Server::mergeTokensToString(const std::vector<std::string> &tokens, bool removeColon) {
+std::string Server::mergeTokensToString(const std::vector<std::string> &tokens) {
 	std::string mergedString;
 	for (size_t i = 0; i < tokens.size(); ++i) {
 		mergedString += tokens[i];
@@ -49,9 +47,6 @@ std::string Server::mergeTokensToString(const std::vector<std::string> &tokens,
 			mergedString += " ";
 		}
 	}
-	if (removeColon && !mergedString.empty() && mergedString[0] == ':') {
-		mergedString.erase(0, 1);
-	}
 	return mergedString;
 }
 